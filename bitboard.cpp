@@ -0,0 +1,168 @@
+#include "bitboard.h"
+#include "board_geometry.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace bitboard_tables {
+	Bitboard knight_attacks[BITBOARD_SQUARES];
+	Bitboard king_attacks[BITBOARD_SQUARES];
+	Bitboard pawn_attacks[2][BITBOARD_SQUARES];
+	MagicEntry rook_magics[BITBOARD_SQUARES];
+	MagicEntry bishop_magics[BITBOARD_SQUARES];
+	Bitboard ray_masks[BITBOARD_SQUARES][8];
+}
+
+namespace {
+
+	constexpr int ROOK_TABLE_SIZE = 0x19000;
+	constexpr int BISHOP_TABLE_SIZE = 0x1480;
+
+	Bitboard rook_table[ROOK_TABLE_SIZE];
+	Bitboard bishop_table[BISHOP_TABLE_SIZE];
+
+	constexpr int ROOK_DIRECTIONS[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+	constexpr int BISHOP_DIRECTIONS[4][2] = { { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } };
+
+	bool OnBoard(int row, int column) {
+		return row >= 0 && row < BITBOARD_SIDE && column >= 0 && column < BITBOARD_SIDE;
+	}
+
+	Bitboard LeaperAttacks(int square, const int (*offsets)[2], int count) {
+		Bitboard output = 0;
+		int row = square / BITBOARD_SIDE;
+		int column = square % BITBOARD_SIDE;
+		for (int i = 0; i < count; ++i) {
+			int n = row + offsets[i][0];
+			int m = column + offsets[i][1];
+			if (OnBoard(n, m)) {
+				output |= SquareBit(n * BITBOARD_SIDE + m);
+			}
+		}
+		return output;
+	}
+
+	// Walks every ray until the first occupied tile (included) or the border
+	Bitboard SlidingAttacks(int square, Bitboard occupied, const int (*directions)[2], int count = 4) {
+		Bitboard output = 0;
+		for (int i = 0; i < count; ++i) {
+			int n = square / BITBOARD_SIDE + directions[i][0];
+			int m = square % BITBOARD_SIDE + directions[i][1];
+			for (; OnBoard(n, m); n += directions[i][0], m += directions[i][1]) {
+				Bitboard bit = SquareBit(n * BITBOARD_SIDE + m);
+				output |= bit;
+				if (occupied & bit) {
+					break;
+				}
+			}
+		}
+		return output;
+	}
+
+	// Tiles that can block a ray. Border tiles never change the attack set, so they are skipped
+	Bitboard RelevantOccupancy(int square, const int (*directions)[2]) {
+		Bitboard output = 0;
+		for (int i = 0; i < 4; ++i) {
+			int n = square / BITBOARD_SIDE + directions[i][0];
+			int m = square % BITBOARD_SIDE + directions[i][1];
+			for (; OnBoard(n + directions[i][0], m + directions[i][1]); n += directions[i][0], m += directions[i][1]) {
+				output |= SquareBit(n * BITBOARD_SIDE + m);
+			}
+		}
+		return output;
+	}
+
+	// xorshift64* generator with a fixed seed, so magics are the same on every run
+	class MagicRandom {
+	public:
+		Bitboard Next() {
+			state_ ^= state_ >> 12;
+			state_ ^= state_ << 25;
+			state_ ^= state_ >> 27;
+			return state_ * 2685821657736338717ull;
+		}
+
+		// Magics with few set bits are found much faster
+		Bitboard Sparse() {
+			return Next() & Next() & Next();
+		}
+
+	private:
+		Bitboard state_ = 728;
+	};
+
+	void InitMagics(MagicEntry* magics, Bitboard* table, const int (*directions)[2], MagicRandom& random) {
+		std::vector<Bitboard> occupancies;
+		std::vector<Bitboard> references;
+		std::vector<int> epoch;
+		int current_epoch = 0;
+		Bitboard* next_attacks = table;
+
+		for (int square = 0; square < BITBOARD_SQUARES; ++square) {
+			MagicEntry& entry = magics[square];
+			entry.mask = RelevantOccupancy(square, directions);
+			entry.shift = unsigned(BITBOARD_SQUARES - CountSquares(entry.mask));
+			entry.attacks = next_attacks;
+
+			// Carry-Rippler enumeration of every subset of the mask
+			occupancies.clear();
+			references.clear();
+			Bitboard subset = 0;
+			do {
+				occupancies.push_back(subset);
+				references.push_back(SlidingAttacks(square, subset, directions));
+				subset = (subset - entry.mask) & entry.mask;
+			} while (subset != 0);
+
+			size_t size = occupancies.size();
+			epoch.assign(size, 0);
+			bool found = false;
+			while (!found) {
+				do {
+					entry.magic = random.Sparse();
+				} while (CountSquares((entry.magic * entry.mask) >> 56) < 6);
+
+				++current_epoch;
+				found = true;
+				for (size_t i = 0; i < size; ++i) {
+					unsigned index = entry.Index(occupancies[i]);
+					if (epoch[index] < current_epoch) {
+						epoch[index] = current_epoch;
+						next_attacks[index] = references[i];
+					}
+					else if (next_attacks[index] != references[i]) {
+						found = false;
+						break;
+					}
+				}
+			}
+			next_attacks += size;
+		}
+	}
+
+	struct TablesInitializer {
+		TablesInitializer() {
+			constexpr int KNIGHT_OFFSETS[8][2] = { { -2, -1 }, { -2, 1 }, { -1, -2 }, { -1, 2 },
+												   { 1, -2 }, { 1, 2 }, { 2, -1 }, { 2, 1 } };
+			constexpr int KING_OFFSETS[8][2] = { { -1, -1 }, { -1, 0 }, { -1, 1 }, { 0, -1 },
+												 { 0, 1 }, { 1, -1 }, { 1, 0 }, { 1, 1 } };
+			constexpr int WHITE_PAWN_OFFSETS[2][2] = { { -1, -1 }, { -1, 1 } };
+			constexpr int BLACK_PAWN_OFFSETS[2][2] = { { 1, -1 }, { 1, 1 } };
+
+			for (int square = 0; square < BITBOARD_SQUARES; ++square) {
+				bitboard_tables::knight_attacks[square] = LeaperAttacks(square, KNIGHT_OFFSETS, 8);
+				bitboard_tables::king_attacks[square] = LeaperAttacks(square, KING_OFFSETS, 8);
+				bitboard_tables::pawn_attacks[0][square] = LeaperAttacks(square, WHITE_PAWN_OFFSETS, 2);
+				bitboard_tables::pawn_attacks[1][square] = LeaperAttacks(square, BLACK_PAWN_OFFSETS, 2);
+				for (int ray = 0; ray < BoardGeometry::RAY_COUNT; ++ray) {
+					bitboard_tables::ray_masks[square][ray] = SlidingAttacks(square, 0, &BoardGeometry::RAY_OFFSETS[ray], 1);
+				}
+			}
+			MagicRandom random;
+			InitMagics(bitboard_tables::rook_magics, rook_table, ROOK_DIRECTIONS, random);
+			InitMagics(bitboard_tables::bishop_magics, bishop_table, BISHOP_DIRECTIONS, random);
+		}
+	};
+
+	const TablesInitializer tables_initializer;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+// Bitboards for the standard 8x8 board
+// Bit index of a tile is row * 8 + column, so bit order matches row-major order of Chess tiles
+using Bitboard = uint64_t;
+
+constexpr int BITBOARD_SIDE = 8;
+constexpr int BITBOARD_SQUARES = BITBOARD_SIDE * BITBOARD_SIDE;
+
+constexpr Bitboard SquareBit(int square) {
+	return Bitboard(1) << square;
+}
+
+inline int LowestSquare(Bitboard board) {
+	return std::countr_zero(board);
+}
+
+// Returns index of the lowest set bit and clears it
+inline int PopLowestSquare(Bitboard& board) {
+	int square = std::countr_zero(board);
+	board &= board - 1;
+	return square;
+}
+
+inline int CountSquares(Bitboard board) {
+	return std::popcount(board);
+}
+
+// Fancy magic bitboard entry for one square
+// Attack set of a slider is attacks[Index(occupied)]
+struct MagicEntry {
+	Bitboard mask = 0;
+	Bitboard magic = 0;
+	const Bitboard* attacks = nullptr;
+	unsigned shift = 0;
+
+	unsigned Index(Bitboard occupied) const {
+		return unsigned(((occupied & mask) * magic) >> shift);
+	}
+};
+
+// Tables are filled once during static initialization of bitboard.cpp
+namespace bitboard_tables {
+	extern Bitboard knight_attacks[BITBOARD_SQUARES];
+	extern Bitboard king_attacks[BITBOARD_SQUARES];
+	// [0] - squares attacked by a white pawn (moving towards row 0), [1] - by a black pawn
+	extern Bitboard pawn_attacks[2][BITBOARD_SQUARES];
+	extern MagicEntry rook_magics[BITBOARD_SQUARES];
+	extern MagicEntry bishop_magics[BITBOARD_SQUARES];
+	extern Bitboard ray_masks[BITBOARD_SQUARES][8];
+}
+
+inline Bitboard KnightAttacks(int square) {
+	return bitboard_tables::knight_attacks[square];
+}
+
+inline Bitboard KingAttacks(int square) {
+	return bitboard_tables::king_attacks[square];
+}
+
+inline Bitboard PawnAttacks(bool is_white, int square) {
+	return bitboard_tables::pawn_attacks[is_white ? 0 : 1][square];
+}
+
+// Tiles from a square (excluded) to the border along a ray, rays are numbered as in BoardGeometry
+inline Bitboard RayMask(int square, int ray) {
+	return bitboard_tables::ray_masks[square][ray];
+}
+
+inline Bitboard RookAttacks(int square, Bitboard occupied) {
+	const MagicEntry& entry = bitboard_tables::rook_magics[square];
+	return entry.attacks[entry.Index(occupied)];
+}
+
+inline Bitboard BishopAttacks(int square, Bitboard occupied) {
+	const MagicEntry& entry = bitboard_tables::bishop_magics[square];
+	return entry.attacks[entry.Index(occupied)];
+}
+
+inline Bitboard QueenAttacks(int square, Bitboard occupied) {
+	return RookAttacks(square, occupied) | BishopAttacks(square, occupied);
+}
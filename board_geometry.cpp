@@ -0,0 +1,266 @@
+#include "board_geometry.h"
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+using namespace std;
+
+namespace {
+
+	// splitmix64, fixed seed so keys of a board size are the same in every run
+	uint64_t NextKey(uint64_t& state) {
+		uint64_t key = (state += 0x9E3779B97F4A7C15ULL);
+		key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		key = (key ^ (key >> 27)) * 0x94D049BB133111EBULL;
+		return key ^ (key >> 31);
+	}
+
+	constexpr int STANDARD_SIDE = 8;
+	constexpr int STANDARD_TILES = STANDARD_SIDE * STANDARD_SIDE;
+	constexpr uint8_t WHITE_INDEX = 1;
+
+	// Piece-square tables of white on the standard board, in centipawns, row 0 is the far (black) side
+	// Indexed by phase and ChessPiece: EMPTY, PAWN, ROOK, BISHOP, KNIGHT, QUEEN, KING
+	// Pawns and kings change between the middlegame and the endgame, the other pieces keep their table
+	constexpr int8_t STANDARD_TABLES[BoardGeometry::PHASE_COUNT][BoardGeometry::PIECE_KINDS][STANDARD_TILES] = {
+		{
+			{},
+			{	// Pawn: hold the king's shelter, take the center
+				  0,   0,   0,   0,   0,   0,   0,   0,
+				 50,  50,  50,  50,  50,  50,  50,  50,
+				 10,  10,  20,  30,  30,  20,  10,  10,
+				  5,   5,  10,  25,  25,  10,   5,   5,
+				  0,   0,   0,  20,  20,   0,   0,   0,
+				  5,  -5, -10,   0,   0, -10,  -5,   5,
+				  5,  10,  10, -20, -20,  10,  10,   5,
+				  0,   0,   0,   0,   0,   0,   0,   0 },
+			{	// Rook: seventh row, central files
+				  0,   0,   0,   0,   0,   0,   0,   0,
+				  5,  10,  10,  10,  10,  10,  10,   5,
+				 -5,   0,   0,   0,   0,   0,   0,  -5,
+				 -5,   0,   0,   0,   0,   0,   0,  -5,
+				 -5,   0,   0,   0,   0,   0,   0,  -5,
+				 -5,   0,   0,   0,   0,   0,   0,  -5,
+				 -5,   0,   0,   0,   0,   0,   0,  -5,
+				  0,   0,   0,   5,   5,   0,   0,   0 },
+			{	// Bishop: long diagonals, away from corners
+				-20, -10, -10, -10, -10, -10, -10, -20,
+				-10,   0,   0,   0,   0,   0,   0, -10,
+				-10,   0,   5,  10,  10,   5,   0, -10,
+				-10,   5,   5,  10,  10,   5,   5, -10,
+				-10,   0,  10,  10,  10,  10,   0, -10,
+				-10,  10,  10,  10,  10,  10,  10, -10,
+				-10,   5,   0,   0,   0,   0,   5, -10,
+				-20, -10, -10, -10, -10, -10, -10, -20 },
+			{	// Knight: the center, never the rim
+				-50, -40, -30, -30, -30, -30, -40, -50,
+				-40, -20,   0,   0,   0,   0, -20, -40,
+				-30,   0,  10,  15,  15,  10,   0, -30,
+				-30,   5,  15,  20,  20,  15,   5, -30,
+				-30,   0,  15,  20,  20,  15,   0, -30,
+				-30,   5,  10,  15,  15,  10,   5, -30,
+				-40, -20,   0,   5,   5,   0, -20, -40,
+				-50, -40, -30, -30, -30, -30, -40, -50 },
+			{	// Queen: slightly central
+				-20, -10, -10,  -5,  -5, -10, -10, -20,
+				-10,   0,   0,   0,   0,   0,   0, -10,
+				-10,   0,   5,   5,   5,   5,   0, -10,
+				 -5,   0,   5,   5,   5,   5,   0,  -5,
+				  0,   0,   5,   5,   5,   5,   0,  -5,
+				-10,   5,   5,   5,   5,   5,   0, -10,
+				-10,   0,   5,   0,   0,   0,   0, -10,
+				-20, -10, -10,  -5,  -5, -10, -10, -20 },
+			{	// King: castled behind its pawns
+				-30, -40, -40, -50, -50, -40, -40, -30,
+				-30, -40, -40, -50, -50, -40, -40, -30,
+				-30, -40, -40, -50, -50, -40, -40, -30,
+				-30, -40, -40, -50, -50, -40, -40, -30,
+				-20, -30, -30, -40, -40, -30, -30, -20,
+				-10, -20, -20, -20, -20, -20, -20, -10,
+				 20,  20,   0,   0,   0,   0,  20,  20,
+				 20,  30,  10,   0,   0,  10,  30,  20 }
+		},
+		{
+			{},
+			{	// Pawn: the closer to promotion the better
+				  0,   0,   0,   0,   0,   0,   0,   0,
+				 80,  80,  80,  80,  80,  80,  80,  80,
+				 50,  50,  50,  50,  50,  50,  50,  50,
+				 30,  30,  30,  30,  30,  30,  30,  30,
+				 15,  15,  15,  15,  15,  15,  15,  15,
+				  5,   5,   5,   5,   5,   5,   5,   5,
+				  0,   0,   0,   0,   0,   0,   0,   0,
+				  0,   0,   0,   0,   0,   0,   0,   0 },
+			{
+				  0,   0,   0,   0,   0,   0,   0,   0,
+				  5,  10,  10,  10,  10,  10,  10,   5,
+				 -5,   0,   0,   0,   0,   0,   0,  -5,
+				 -5,   0,   0,   0,   0,   0,   0,  -5,
+				 -5,   0,   0,   0,   0,   0,   0,  -5,
+				 -5,   0,   0,   0,   0,   0,   0,  -5,
+				 -5,   0,   0,   0,   0,   0,   0,  -5,
+				  0,   0,   0,   5,   5,   0,   0,   0 },
+			{
+				-20, -10, -10, -10, -10, -10, -10, -20,
+				-10,   0,   0,   0,   0,   0,   0, -10,
+				-10,   0,   5,  10,  10,   5,   0, -10,
+				-10,   5,   5,  10,  10,   5,   5, -10,
+				-10,   0,  10,  10,  10,  10,   0, -10,
+				-10,  10,  10,  10,  10,  10,  10, -10,
+				-10,   5,   0,   0,   0,   0,   5, -10,
+				-20, -10, -10, -10, -10, -10, -10, -20 },
+			{
+				-50, -40, -30, -30, -30, -30, -40, -50,
+				-40, -20,   0,   0,   0,   0, -20, -40,
+				-30,   0,  10,  15,  15,  10,   0, -30,
+				-30,   5,  15,  20,  20,  15,   5, -30,
+				-30,   0,  15,  20,  20,  15,   0, -30,
+				-30,   5,  10,  15,  15,  10,   5, -30,
+				-40, -20,   0,   5,   5,   0, -20, -40,
+				-50, -40, -30, -30, -30, -30, -40, -50 },
+			{
+				-20, -10, -10,  -5,  -5, -10, -10, -20,
+				-10,   0,   0,   0,   0,   0,   0, -10,
+				-10,   0,   5,   5,   5,   5,   0, -10,
+				 -5,   0,   5,   5,   5,   5,   0,  -5,
+				  0,   0,   5,   5,   5,   5,   0,  -5,
+				-10,   5,   5,   5,   5,   5,   0, -10,
+				-10,   0,   5,   0,   0,   0,   0, -10,
+				-20, -10, -10,  -5,  -5, -10, -10, -20 },
+			{	// King: comes out to the center
+				-50, -40, -30, -20, -20, -30, -40, -50,
+				-30, -20, -10,   0,   0, -10, -20, -30,
+				-30, -10,  20,  30,  30,  20, -10, -30,
+				-30, -10,  30,  40,  40,  30, -10, -30,
+				-30, -10,  30,  40,  40,  30, -10, -30,
+				-30, -10,  20,  30,  30,  20, -10, -30,
+				-30, -30,   0,   0,   0,   0, -30, -30,
+				-50, -30, -30, -30, -30, -30, -30, -50 }
+		}
+	};
+
+	// Nearest row or column of the standard board, the first and last ones map to its edges
+	constexpr int StretchToStandard(int index, int count) {
+		if (count <= 1) {
+			return 0;
+		}
+		return (index * (STANDARD_SIDE - 1) * 2 + (count - 1)) / (2 * (count - 1));
+	}
+
+	// Score of a piece of a team on a square of a (rows x columns) board. Black reads the tables upside down
+	constexpr int16_t StretchedScore(int phase, uint8_t team, uint8_t piece, int square, int rows, int columns) {
+		if (team == 0) {
+			return 0;
+		}
+		int row = square / columns;
+		int own_row = (team == WHITE_INDEX) ? row : rows - 1 - row;
+		int standard_square = StretchToStandard(own_row, rows) * STANDARD_SIDE + StretchToStandard(square % columns, columns);
+		return STANDARD_TABLES[phase][piece][standard_square];
+	}
+
+	constexpr size_t STANDARD_SCORE_COUNT =
+		size_t(BoardGeometry::PHASE_COUNT) * BoardGeometry::TEAM_KINDS * BoardGeometry::PIECE_KINDS * STANDARD_TILES;
+
+	// Laid out as BoardGeometry::SquareScore() reads them
+	constexpr array<int16_t, STANDARD_SCORE_COUNT> BuildStandardScores() {
+		array<int16_t, STANDARD_SCORE_COUNT> scores = {};
+		size_t index = 0;
+		for (int phase = 0; phase < BoardGeometry::PHASE_COUNT; ++phase) {
+			for (int team = 0; team < BoardGeometry::TEAM_KINDS; ++team) {
+				for (int piece = 0; piece < BoardGeometry::PIECE_KINDS; ++piece) {
+					for (int square = 0; square < STANDARD_TILES; ++square) {
+						scores[index++] = StretchedScore(phase, uint8_t(team), uint8_t(piece), square, STANDARD_SIDE,
+							STANDARD_SIDE);
+					}
+				}
+			}
+		}
+		return scores;
+	}
+
+	constexpr array<int16_t, STANDARD_SCORE_COUNT> STANDARD_SQUARE_SCORES = BuildStandardScores();
+	static_assert(STANDARD_SQUARE_SCORES[STANDARD_TILES * BoardGeometry::PIECE_KINDS + STANDARD_TILES + 8] == 50,
+		"White pawns one row before promotion");
+}
+
+// Thread safe, returned reference stays valid for the lifetime of the program
+const BoardGeometry& BoardGeometry::For(int rows, int columns) {
+	static mutex registry_mutex;
+	static map<pair<int, int>, unique_ptr<BoardGeometry>> registry;
+
+	lock_guard<mutex> lock(registry_mutex);
+	unique_ptr<BoardGeometry>& geometry = registry[{ rows, columns }];
+	if (!geometry) {
+		geometry = make_unique<BoardGeometry>(rows, columns);
+	}
+	return *geometry;
+}
+
+BoardGeometry::BoardGeometry(int rows, int columns) : rows_(rows), columns_(columns) {
+	for (int ray = 0; ray < RAY_COUNT; ++ray) {
+		ray_steps_[ray] = RAY_OFFSETS[ray][0] * columns + RAY_OFFSETS[ray][1];
+	}
+	for (int jump = 0; jump < KNIGHT_JUMP_COUNT; ++jump) {
+		knight_steps_[jump] = KNIGHT_OFFSETS[jump][0] * columns + KNIGHT_OFFSETS[jump][1];
+	}
+	int tile_count = max(rows * columns, 0);
+	ray_lengths_.resize(size_t(tile_count) * RAY_COUNT);
+	knight_jumps_.resize(tile_count);
+
+	for (int row = 0; row < rows; ++row) {
+		for (int column = 0; column < columns; ++column) {
+			int square = row * columns + column;
+			for (int ray = 0; ray < RAY_COUNT; ++ray) {
+				int length = rows + columns;
+				if (RAY_OFFSETS[ray][0] != 0) {
+					length = min(length, RAY_OFFSETS[ray][0] > 0 ? rows - 1 - row : row);
+				}
+				if (RAY_OFFSETS[ray][1] != 0) {
+					length = min(length, RAY_OFFSETS[ray][1] > 0 ? columns - 1 - column : column);
+				}
+				ray_lengths_[square * RAY_COUNT + ray] = uint16_t(length);
+			}
+			uint8_t jumps = 0;
+			for (int jump = 0; jump < KNIGHT_JUMP_COUNT; ++jump) {
+				int n = row + KNIGHT_OFFSETS[jump][0];
+				int m = column + KNIGHT_OFFSETS[jump][1];
+				if (n >= 0 && n < rows && m >= 0 && m < columns) {
+					jumps |= uint8_t(1 << jump);
+				}
+			}
+			knight_jumps_[square] = jumps;
+		}
+	}
+
+	uint64_t seed = 0x5A0B1257ULL;
+	tile_keys_.resize(size_t(tile_count) * TILE_KEY_KINDS * 2);
+	for (uint64_t& key : tile_keys_) {
+		key = NextKey(seed);
+	}
+	en_passant_keys_.resize(max(columns, 0));
+	for (uint64_t& key : en_passant_keys_) {
+		key = NextKey(seed);
+	}
+	side_key_ = NextKey(seed);
+
+	if (rows == STANDARD_SIDE && columns == STANDARD_SIDE) {
+		square_scores_ = STANDARD_SQUARE_SCORES.data();
+		return;
+	}
+	stretched_scores_.resize(size_t(PHASE_COUNT) * TEAM_KINDS * PIECE_KINDS * tile_count);
+	size_t index = 0;
+	for (int phase = 0; phase < PHASE_COUNT; ++phase) {
+		for (int team = 0; team < TEAM_KINDS; ++team) {
+			for (int piece = 0; piece < PIECE_KINDS; ++piece) {
+				for (int square = 0; square < tile_count; ++square) {
+					stretched_scores_[index++] = StretchedScore(phase, uint8_t(team), uint8_t(piece), square, rows, columns);
+				}
+			}
+		}
+	}
+	square_scores_ = stretched_scores_.data();
+}
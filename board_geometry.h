@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Direction, offset, key and piece-square tables for one board size
+// Built once per (n x m) the first time a board of that size is constructed, then shared by all boards
+// of that size and never freed or copied, so Chess only keeps a pointer and copies stay cheap
+class BoardGeometry {
+public:
+	// Rays 0-3 are orthogonal, 4-7 are diagonal
+	static constexpr int RAY_COUNT = 8;
+	static constexpr int ORTHOGONAL_RAYS_END = 4;
+	static constexpr int RAY_OFFSETS[RAY_COUNT][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 },
+													   { -1, -1 }, { -1, 1 }, { 1, -1 }, { 1, 1 } };
+
+	// Ray pointing the other way: 0 <-> 1, 2 <-> 3, 4 <-> 7, 5 <-> 6
+	static constexpr int OppositeRay(int ray) {
+		return (ray < ORTHOGONAL_RAYS_END) ? (ray ^ 1) : (11 - ray);
+	}
+
+	static constexpr int KNIGHT_JUMP_COUNT = 8;
+	static constexpr int KNIGHT_OFFSETS[KNIGHT_JUMP_COUNT][2] = { { -2, -1 }, { -2, 1 }, { -1, -2 }, { -1, 2 },
+																  { 1, -2 }, { 1, 2 }, { 2, -1 }, { 2, 1 } };
+
+	// Values of ChessPiece and ChessTeam, which this header does not see
+	static constexpr int PIECE_KINDS = 7;
+	static constexpr int TEAM_KINDS = 3;
+
+	// Piece-square tables come in two phases, 0 for the middlegame and 1 for the endgame
+	static constexpr int PHASE_COUNT = 2;
+
+	// Thread safe, returned reference stays valid for the lifetime of the program
+	static const BoardGeometry& For(int rows, int columns);
+
+	BoardGeometry(int rows, int columns);
+
+	int GetRows() const {
+		return rows_;
+	}
+
+	int GetColumns() const {
+		return columns_;
+	}
+
+	// Index difference of one step along a ray
+	int RayStep(int ray) const {
+		return ray_steps_[ray];
+	}
+
+	// Number of tiles between a square and the border along a ray
+	int RayLength(int square, int ray) const {
+		return ray_lengths_[square * RAY_COUNT + ray];
+	}
+
+	int KnightStep(int jump) const {
+		return knight_steps_[jump];
+	}
+
+	// Bit i is set if KNIGHT_OFFSETS[i] stays on the board
+	uint8_t KnightJumps(int square) const {
+		return knight_jumps_[square];
+	}
+
+	// Zobrist keys of this board size, the same in every run
+	// A tile is keyed by team, piece and has_moved. has_moved only counts for pawns (double step),
+	// rooks and kings (castling), other pieces always use the unmoved key. Empty tiles have no key
+	uint64_t TileKey(int square, uint8_t team, uint8_t piece, bool has_moved) const {
+		if (piece == 0) {
+			return 0;
+		}
+		bool keeps_moved = has_moved && (piece == PAWN_INDEX || piece == ROOK_INDEX || piece == KING_INDEX);
+		return tile_keys_[(size_t(square) * TILE_KEY_KINDS + team * PIECE_KINDS + piece) * 2 + keeps_moved];
+	}
+
+	// Black to move
+	uint64_t SideKey() const {
+		return side_key_;
+	}
+
+	// En passant capture possible on a column
+	uint64_t EnPassantKey(int column) const {
+		return en_passant_keys_[column];
+	}
+
+	// Bonus in centipawns for a piece standing on a square, seen from its own team. Empty tiles and
+	// NEUTRAL pieces get 0
+	// The 8x8 tables are built at compile time, those of other sizes are stretched from them once per size
+	int SquareScore(int phase, int square, uint8_t team, uint8_t piece) const {
+		return square_scores_[((size_t(phase) * TEAM_KINDS + team) * PIECE_KINDS + piece) * (rows_ * columns_) + square];
+	}
+
+private:
+	static constexpr int TILE_KEY_KINDS = TEAM_KINDS * PIECE_KINDS;
+	static constexpr uint8_t PAWN_INDEX = 1;
+	static constexpr uint8_t ROOK_INDEX = 2;
+	static constexpr uint8_t KING_INDEX = 6;
+
+	int rows_ = 0;
+	int columns_ = 0;
+	int ray_steps_[RAY_COUNT] = {};
+	int knight_steps_[KNIGHT_JUMP_COUNT] = {};
+	std::vector<uint16_t> ray_lengths_;
+	std::vector<uint8_t> knight_jumps_;
+	std::vector<uint64_t> tile_keys_;
+	std::vector<uint64_t> en_passant_keys_;
+	uint64_t side_key_ = 0;
+	// Points to the compile-time tables on 8x8 boards, to stretched_scores_ on all others
+	const int16_t* square_scores_ = nullptr;
+	std::vector<int16_t> stretched_scores_;
+};
@@ -3,74 +3,66 @@
 #include <algorithm>
 #include <deque>
 #include <iostream>
-#include <new>
 #include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
 
 using namespace std;
 
 constexpr int STANDART_BOARD_WIDTH = 8;
 constexpr int STANDART_BOARD_LENGTH = 8;
 
-// Board has matrix-like dimensions of (n x m), where an element of 1x1 board has coordinates (0, 0)
-Chess::Chess(int n, int m) {
-	try {
-		BoardTile** row_ptr = new BoardTile * [n];
-		rows_ = n;
-		columns_ = m;
-		array_ptr_ = row_ptr;
-		for (int i = 0; i < n; ++i) {
-			BoardTile* column_ptr = new BoardTile[m];
-			row_ptr[i] = column_ptr;
+namespace {
+	// A Move can't address more than Chess::MAX_TILES tiles, bigger boards are refused
+	const BoardGeometry& CheckedGeometry(int n, int m) {
+		if (int64_t(n) * m > Chess::MAX_TILES) {
+			throw std::invalid_argument("Board has more than Chess::MAX_TILES tiles"s);
 		}
+		return BoardGeometry::For(n, m);
 	}
-	catch (const bad_alloc&) {
-		CleanUp();
-		throw;
+}
+
+// Board has matrix-like dimensions of (n x m), where an element of 1x1 board has coordinates (0, 0)
+// Boards up to INLINE_TILES tiles live inside the object, bigger ones take a single heap block
+// Throws std::invalid_argument for more than MAX_TILES tiles
+Chess::Chess(int n, int m) : rows_(n), columns_(m), geometry_(&CheckedGeometry(n, m)) {
+	if (GetTileCount() > INLINE_TILES) {
+		storage_ = new unsigned char[GetStorageSize()]();
 	}
+	BindStorage();
 }
 
 // Classic game of chess piece setup
 Chess::Chess() : Chess(STANDART_BOARD_WIDTH, STANDART_BOARD_LENGTH) {
 	for (int row = 0; row < rows_; row += 7) {                             // To avoid code duplication
 		ChessTeam team = (row == 0) ? ChessTeam::BLACK : ChessTeam::WHITE;
-		array_ptr_[row][0] = { ChessPiece::ROOK, team, false };
-		array_ptr_[row][1] = { ChessPiece::KNIGHT, team, false };
-		array_ptr_[row][2] = { ChessPiece::BISHOP, team, false };
-		array_ptr_[row][3] = { ChessPiece::QUEEN, team, false };
-		array_ptr_[row][4] = { ChessPiece::KING, team, false };
-		array_ptr_[row][5] = { ChessPiece::BISHOP, team, false };
-		array_ptr_[row][6] = { ChessPiece::KNIGHT, team, false };
-		array_ptr_[row][7] = { ChessPiece::ROOK, team, false };
+		PlaceTile(row, 0, { ChessPiece::ROOK, team, false });
+		PlaceTile(row, 1, { ChessPiece::KNIGHT, team, false });
+		PlaceTile(row, 2, { ChessPiece::BISHOP, team, false });
+		PlaceTile(row, 3, { ChessPiece::QUEEN, team, false });
+		PlaceTile(row, 4, { ChessPiece::KING, team, false });
+		PlaceTile(row, 5, { ChessPiece::BISHOP, team, false });
+		PlaceTile(row, 6, { ChessPiece::KNIGHT, team, false });
+		PlaceTile(row, 7, { ChessPiece::ROOK, team, false });
 	}
 	for (int column = 0; column < columns_; ++column) {
-		array_ptr_[1][column] = { ChessPiece::PAWN, ChessTeam::BLACK, false };
+		PlaceTile(1, column, { ChessPiece::PAWN, ChessTeam::BLACK, false });
 	}
 	for (int column = 0; column < columns_; ++column) {
-		array_ptr_[6][column] = { ChessPiece::PAWN, ChessTeam::WHITE, false };
+		PlaceTile(6, column, { ChessPiece::PAWN, ChessTeam::WHITE, false });
 	}
 }
 
-// Creates a copy of a board state and stores it in newly allocated memory
-// array_ptr_ will be unique
-Chess::Chess(const Chess& source) : Chess(source.GetDimensions().first, source.GetDimensions().second) {
-	for (int row = 0; row < rows_; ++row) {
-		for (int column = 0; column < columns_; ++column) {
-			const BoardTile& tile = source.LookUp(row, column);
-			this->PutPieceInPosition(tile, row, column);
-		}
-	}
-	this->en_passant_ = source.en_passant_;
-	this->pawn_promotion_ = source.pawn_promotion_;
-	this->is_whites_move_ = source.is_whites_move_;
+// Creates a copy of a board state with a single memcpy of the board buffer
+// storage_ will be unique
+Chess::Chess(const Chess& source) : Chess(source.rows_, source.columns_) {
+	CopyState(source);
 }
 
+// Heap buffers are stolen, inline ones are copied. Source is left as an empty 0x0 board
 Chess::Chess(Chess&& source) noexcept {
-	std::swap(array_ptr_, source.array_ptr_);
-	std::swap(rows_, source.rows_);
-	std::swap(columns_, source.columns_);
-	is_whites_move_ = source.is_whites_move_;
-	en_passant_ = source.en_passant_;
-	pawn_promotion_ = source.pawn_promotion_;
+	TakeOver(source);
 }
 
 // Copies board state. Previous state of *this is destroyed
@@ -78,43 +70,37 @@ Chess& Chess::operator=(const Chess& source) {
 	if (&source == this) {
 		return *this;
 	}
-	Chess copy(source);
-	// Swap necessary for copy's destructor
-	std::swap(this->array_ptr_, copy.array_ptr_);
-	std::swap(this->rows_, copy.rows_);
-	std::swap(this->columns_, copy.columns_);
-	this->en_passant_ = copy.en_passant_;
-	this->pawn_promotion_ = copy.pawn_promotion_;
-	this->is_whites_move_ = copy.is_whites_move_;
+	if (GetTileCount() != source.GetTileCount()) {
+		Chess copy(source);
+		CleanUp();
+		TakeOver(copy);
+		return *this;
+	}
+	rows_ = source.rows_;
+	columns_ = source.columns_;
+	CopyState(source);
 	return *this;
 }
 
-// Essentially swaps contents
+// Same as the move constructor, previous state of *this is destroyed
 Chess& Chess::operator=(Chess&& source) noexcept {
 	if (&source != this) {
-		std::swap(this->array_ptr_, source.array_ptr_);
-		std::swap(this->rows_, source.rows_);
-		std::swap(this->columns_, source.columns_);
-		this->en_passant_ = source.en_passant_;
-		this->pawn_promotion_ = source.pawn_promotion_;
-		this->is_whites_move_ = source.is_whites_move_;
+		CleanUp();
+		TakeOver(source);
 	}
 	return *this;
 }
 
 BoardTile Chess::LookUp(int row, int column) const {
 	if (!CheckOutOfBounds(row, column)) {
-		return array_ptr_[row][column];
+		return TileAt(row, column);
 	}
 	return {};
 }
 
 void Chess::FillBoardWith(const BoardTile& piece) {
-	for (int i = 0; i < rows_; ++i) {
-		for (int k = 0; k < columns_; ++k) {
-			array_ptr_[i][k] = piece;
-		}
-	}
+	std::fill(tiles_, tiles_ + GetTileCount(), PackedTile(piece));
+	RebuildIncrementalState();
 }
 
 void Chess::FillBoardWithPawns() {
@@ -127,193 +113,132 @@ void Chess::EmptyBoard() {
 
 void Chess::PutPieceInPosition(const BoardTile& piece, int row, int column) {
 	if (!CheckOutOfBounds(row, column)) {
-		array_ptr_[row][column] = piece;
-	}
-}
-
-// Gives all possible destination tiles on the board for a selected piece
-deque<pair<int, int>> Chess::GetPossibleDestTiles(int n_input, int m_input) const {
-	deque<pair<int, int>> output;
-	if (!CheckValidPieceSelected(n_input, m_input)) {
-		return output;
-	}
-	for (int n = 0; n < rows_; ++n) {        // Brute force. Inefficient for large boards
-		for (int m = 0; m < columns_; ++m) {
-			if (CheckLegalPieceMove(n_input, m_input, n, m)) {
-				// Castling
-				if (array_ptr_[n_input][m_input].piece_type == ChessPiece::KING && std::abs(m_input - m) == 2) {
-					if(CastlingCheckRequirements(n_input, m_input, n, m)){
-						output.push_back({ n, m });
-					}
-				}
-				// En passant
-				else if (array_ptr_[n_input][m_input].piece_type == ChessPiece::PAWN &&
-					en_passant_.first && n == en_passant_.second.first && m == en_passant_.second.second) {
-					BoardTile enemy_pawn = array_ptr_[n_input][m];
-					if (enemy_pawn.piece_team == ChessTeam::NEUTRAL) {
-						continue;
-					}
-					array_ptr_[n][m] = array_ptr_[n_input][m_input];
-					array_ptr_[n_input][m_input] = { ChessPiece::EMPTY, ChessTeam::NEUTRAL, false };
-					array_ptr_[n_input][m] = { ChessPiece::EMPTY, ChessTeam::NEUTRAL, false };
-					if (!IsCheck(array_ptr_[n][m].piece_team)) {
-						output.push_back({ n, m });
-					}
-					array_ptr_[n_input][m_input] = array_ptr_[n][m];
-					array_ptr_[n][m] = { ChessPiece::EMPTY, ChessTeam::NEUTRAL, false };
-					array_ptr_[n_input][m] = enemy_pawn;
-				}
-				// All else
-				else if (!CheckCollision(n_input, m_input, n, m)){
-					BoardTile dest_tile = array_ptr_[n][m];
-					array_ptr_[n][m] = array_ptr_[n_input][m_input];
-					array_ptr_[n_input][m_input] = { ChessPiece::EMPTY, ChessTeam::NEUTRAL, false };
-					if (!IsCheck(array_ptr_[n][m].piece_team)) {
-						output.push_back({ n, m });
-					}
-					array_ptr_[n_input][m_input] = array_ptr_[n][m];
-					array_ptr_[n][m] = dest_tile;
-				}
-			}
-		}
+		PlaceTile(row, column, piece);
 	}
-	return output;
 }
 
 // Avoids rule checks and makes a move
 // If used after GetPossibleTiles(), avoids redundancy
 void Chess::ForceMove(std::pair<int, int> input_pos, std::pair<int, int> output_pos) {
+	MakeMove(DescribeMove(input_pos.first * columns_ + input_pos.second, output_pos.first * columns_ + output_pos.second));
+}
+
+// Makes a move given by GenerateLegalMoves() for this position, no rule checks
+// A promotion piece is placed right away, a promoting move without one leaves PawnPromotion() pending
+Chess::UndoInfo Chess::MakeMove(Move move) {
+	UndoInfo undo;
+	undo.en_passant = en_passant_;
+	undo.pawn_promotion = pawn_promotion_;
+	int from = move.From();
+	int dest = move.To();
+	PackedTile moved_piece = tiles_[from];
+	undo.moved = moved_piece;
 
 	// Assumed false unless stated otherwise
-	en_passant_.first = false;
-	// Castling required additional rook reposition
-	if (array_ptr_[input_pos.first][input_pos.second].piece_type == ChessPiece::KING &&
-		std::abs(input_pos.second - output_pos.second) == 2) {
-
-		int8_t increment_m = (output_pos.second > input_pos.second) ? 1 : -1;
-		BoardTile rook;
-		int pos_m = input_pos.second;
-		while (rook.piece_type != ChessPiece::ROOK) {
-			pos_m += increment_m;
-			rook = array_ptr_[input_pos.first][pos_m];
+	SetEnpassantData({ false, en_passant_.second });
+	if (move.IsCastling()) {
+		// Castling requires additional rook reposition, the first rook towards dest jumps over the king
+		int increment = (dest > from) ? 1 : -1;
+		int row_start = from - from % columns_;
+		for (int pos = from + increment; pos >= row_start && pos < row_start + columns_; pos += increment) {
+			if (tiles_[pos].Piece() == ChessPiece::ROOK) {
+				undo.rook_square = pos;
+				undo.rook = tiles_[pos];
+				break;
+			}
 		}
-		rook.has_moved = true;
-		array_ptr_[input_pos.first][pos_m] = { ChessPiece::EMPTY, ChessTeam::NEUTRAL, false };
-		array_ptr_[input_pos.first][output_pos.second - increment_m] = rook;
-	}
-	else if (array_ptr_[input_pos.first][input_pos.second].piece_type == ChessPiece::PAWN) {
-
-		if (std::abs(input_pos.first - output_pos.first) == 2) {
-			en_passant_.first = true;
-			en_passant_.second.first = (input_pos.first + output_pos.first) / 2;
-			en_passant_.second.second = output_pos.second;
+		if (undo.rook_square >= 0) {
+			PackedTile rook = undo.rook;
+			rook.SetMoved();
+			PlaceTile(undo.rook_square, PackedTile());
+			PlaceTile(dest - increment, rook);
 		}
-		else if (std::abs(input_pos.second - output_pos.second) == 1 &&
-			array_ptr_[output_pos.first][output_pos.second].piece_team == ChessTeam::NEUTRAL) {
-
-			array_ptr_[input_pos.first][output_pos.second] = { ChessPiece::EMPTY, ChessTeam::NEUTRAL, false };
+	}
+	else {
+		undo.captured_square = dest;
+		if (moved_piece.Piece() == ChessPiece::PAWN) {
+			int from_row = from / columns_;
+			int dest_row = dest / columns_;
+			if (std::abs(from_row - dest_row) == 2) {
+				SetEnpassantData({ true, { (from_row + dest_row) / 2, dest % columns_ } });
+			}
+			else if (move.IsEnPassant()) {
+				undo.captured_square = from - from % columns_ + dest % columns_;
+			}
+			if (dest_row == 0 || dest_row == rows_ - 1) {
+				pawn_promotion_.first = !move.IsPromotion();
+				pawn_promotion_.second = { dest_row, dest % columns_ };
+				if (move.IsPromotion()) {
+					moved_piece.SetPiece(move.Promotion());
+				}
+			}
 		}
-		if (output_pos.first == 0 || output_pos.first == rows_ - 1) {
-			pawn_promotion_.first = true;
-			pawn_promotion_.second = { output_pos.first, output_pos.second };
+		undo.captured = tiles_[undo.captured_square];
+		if (undo.captured_square != dest) {
+			PlaceTile(undo.captured_square, PackedTile());
 		}
 	}
-	array_ptr_[output_pos.first][output_pos.second] = array_ptr_[input_pos.first][input_pos.second];
-	array_ptr_[output_pos.first][output_pos.second].has_moved = true;
-	array_ptr_[input_pos.first][input_pos.second] = { ChessPiece::EMPTY, ChessTeam::NEUTRAL, false };
-	is_whites_move_ = (is_whites_move_) ? 0 : 1;
+	moved_piece.SetMoved();
+	PlaceTile(from, PackedTile());
+	PlaceTile(dest, moved_piece);
+	FlipTurn();
+	return undo;
 }
 
-// Does all the necessary checks, moves a piece and returns 'true'
-// Or does nothing and returns 'false' if the move is illegal
-bool Chess::MovePiece(pair<int, int> input_pos, pair<int, int> dest_pos) {
-	if (CheckValidPieceSelected(input_pos.first, input_pos.second) && CheckCorrectTurnSequence(input_pos.first, input_pos.second) &&
-		CheckLegalPieceMove(input_pos.first, input_pos.second, dest_pos.first, dest_pos.second)) {
-
-		if (array_ptr_[input_pos.first][input_pos.second].piece_type == ChessPiece::KING &&  // Castling shenanigans
-			std::abs(input_pos.second - dest_pos.second) == 2) {
-			if (CastlingCheckRequirements(input_pos.first, input_pos.second, dest_pos.first, dest_pos.second)) {
-				int increment_m = (input_pos.second > dest_pos.second) ? 1 : -1;
-				BoardTile Rook;
-				int m_pos = input_pos.second;
-				while (Rook.piece_type != ChessPiece::ROOK) {
-					m_pos -= increment_m;
-					Rook = array_ptr_[input_pos.first][m_pos];
-				}
-				array_ptr_[input_pos.first][m_pos] = { ChessPiece::EMPTY, ChessTeam::NEUTRAL, false };
-				Rook.has_moved = true;
-				array_ptr_[input_pos.first][dest_pos.second + increment_m] = Rook;
-				array_ptr_[dest_pos.first][dest_pos.second] = array_ptr_[input_pos.first][input_pos.second];
-				array_ptr_[dest_pos.first][dest_pos.second].has_moved = true;
-				array_ptr_[input_pos.first][input_pos.second] = { ChessPiece::EMPTY, ChessTeam::NEUTRAL, false };
-				is_whites_move_ = (is_whites_move_) ? 0 : 1;
-				en_passant_.first = false;
-				return true;
-			}
-			return false;
+// Takes back the last MakeMove(). Tiles, turn, en passant, promotion and all derived state are restored,
+// only the order of GetPieces() may differ
+void Chess::UnmakeMove(Move move, const UndoInfo& undo) {
+	int from = move.From();
+	int dest = move.To();
+	if (move.IsCastling()) {
+		PlaceTile(dest, PackedTile());
+		if (undo.rook_square >= 0) {
+			PlaceTile(dest - ((dest > from) ? 1 : -1), PackedTile());
+			PlaceTile(undo.rook_square, undo.rook);
 		}
+	}
+	else if (undo.captured_square == dest) {
+		PlaceTile(dest, undo.captured);
+	}
+	else {
+		PlaceTile(dest, PackedTile());
+		PlaceTile(undo.captured_square, undo.captured);
+	}
+	PlaceTile(from, undo.moved);
+	SetEnpassantData(undo.en_passant);
+	pawn_promotion_ = undo.pawn_promotion;
+	FlipTurn();
+}
 
-		if (array_ptr_[input_pos.first][input_pos.second].piece_type == ChessPiece::PAWN && // En passant logic
-			en_passant_.first &&
-			dest_pos.first == en_passant_.second.first && dest_pos.second == en_passant_.second.second) {
-
-			BoardTile enemy_pawn = array_ptr_[input_pos.first][dest_pos.second];
-			if (enemy_pawn.piece_team == ChessTeam::NEUTRAL) { // Pointless with classic turn sequence
-				return false;
-			}
-			array_ptr_[dest_pos.first][dest_pos.second] = array_ptr_[input_pos.first][input_pos.second];
-			array_ptr_[input_pos.first][input_pos.second] = { ChessPiece::EMPTY, ChessTeam::NEUTRAL, false };
-			array_ptr_[input_pos.first][dest_pos.second] = { ChessPiece::EMPTY, ChessTeam::NEUTRAL, false };
-
-			if (IsCheck(WhoseMove())) {
-				array_ptr_[input_pos.first][dest_pos.second] = enemy_pawn;
-				array_ptr_[input_pos.first][input_pos.second] = array_ptr_[dest_pos.first][dest_pos.second];
-				array_ptr_[dest_pos.first][dest_pos.second] = { ChessPiece::EMPTY, ChessTeam::NEUTRAL, false };
-				return false;
-			}
-
-			en_passant_.first = false;
-			array_ptr_[dest_pos.first][dest_pos.second].has_moved = true;
-			is_whites_move_ = (is_whites_move_) ? 0 : 1;
-			return true;
-		}
+// Passes the turn without moving, as null-move pruning of a search needs. En passant is dropped
+Chess::UndoInfo Chess::MakeNullMove() {
+	UndoInfo undo;
+	undo.en_passant = en_passant_;
+	undo.pawn_promotion = pawn_promotion_;
+	SetEnpassantData({ false, en_passant_.second });
+	FlipTurn();
+	return undo;
+}
 
+void Chess::UnmakeNullMove(const UndoInfo& undo) {
+	SetEnpassantData(undo.en_passant);
+	pawn_promotion_ = undo.pawn_promotion;
+	FlipTurn();
+}
 
-		if (!CheckCollision(input_pos.first, input_pos.second, dest_pos.first, dest_pos.second)){
-			BoardTile dest_tile = array_ptr_[dest_pos.first][dest_pos.second];
-			array_ptr_[dest_pos.first][dest_pos.second] = array_ptr_[input_pos.first][input_pos.second];
-			array_ptr_[input_pos.first][input_pos.second] = { ChessPiece::EMPTY, ChessTeam::NEUTRAL, false };
-			
-			if (IsCheck(WhoseMove())) { // A move that makes it possible for an opponent to capture king is illegal
-				array_ptr_[input_pos.first][input_pos.second] = array_ptr_[dest_pos.first][dest_pos.second];
-				array_ptr_[dest_pos.first][dest_pos.second] = dest_tile;
-				return false;
-			}
+// Does all the necessary checks, moves a piece and returns 'true'
+// Or does nothing and returns 'false' if the move is illegal
+bool Chess::MovePiece(pair<int, int> input_pos, pair<int, int> dest_pos) {
+	if (CheckValidPieceSelected(input_pos.first, input_pos.second) &&
+		CheckCorrectTurnSequence(input_pos.first, input_pos.second) &&
+		IsLegalMove(input_pos.first * columns_ + input_pos.second, dest_pos.first, dest_pos.second)) {
 
-			en_passant_.first = false;
-			dest_tile = array_ptr_[dest_pos.first][dest_pos.second];
-			if (dest_tile.piece_type == ChessPiece::PAWN) {
-				// Record en passant to memory
-				if (std::abs(dest_pos.first - input_pos.first) == 2) {
-					int8_t increment_n = dest_tile.piece_team == ChessTeam::WHITE ? 1 : -1;
-					en_passant_.first = true;
-					en_passant_.second = { dest_pos.first + increment_n, dest_pos.second };
-				}
-				// If pawn reached the end of the board
-				if (dest_pos.first == 0 || dest_pos.first == rows_ - 1) {
-					pawn_promotion_.first = true;
-					pawn_promotion_.second = { dest_pos.first, dest_pos.second };
-				}
-			}
-			array_ptr_[dest_pos.first][dest_pos.second].has_moved = true;
-			is_whites_move_ = (is_whites_move_) ? 0 : 1;
-			return true;
-		}
+		ForceMove(input_pos, dest_pos);
+		return true;
 	}
 	return false;
 }
 
-
 pair<int, int> Chess::GetDimensions() const {
 	return { rows_, columns_ };
 }
@@ -329,7 +254,9 @@ ChessTeam Chess::WhoseMove() const {
 // Requires a wrapper to work properly
 // Otherwise turn sequence and team ownership are ignored
 void Chess::PawnPromotion(ChessPiece piece) {
-	array_ptr_[pawn_promotion_.second.first][pawn_promotion_.second.second].piece_type = piece;
+	PackedTile promoted = TileAt(pawn_promotion_.second.first, pawn_promotion_.second.second);
+	promoted.SetPiece(piece);
+	PlaceTile(pawn_promotion_.second.first, pawn_promotion_.second.second, promoted);
 	pawn_promotion_.first = false;
 }
 
@@ -338,11 +265,17 @@ void Chess::PawnPromotion(ChessPiece piece) {
 }
 
 void Chess::SetEnpassantData(std::pair<bool, std::pair<int, int>> source) {
+	if (en_passant_.first) {
+		zobrist_key_ ^= geometry_->EnPassantKey(en_passant_.second.second);
+	}
 	en_passant_ = source;
+	if (en_passant_.first) {
+		zobrist_key_ ^= geometry_->EnPassantKey(en_passant_.second.second);
+	}
 }
 
 void Chess::SwitchTurnSequence() {
-	is_whites_move_ = (is_whites_move_) ? false : true;
+	FlipTurn();
 }
 
 bool Chess::CheckOutOfBounds(int row, int column) const {
@@ -358,7 +291,7 @@ bool Chess::CheckOutOfBounds(int row, int column) const {
 // Can't move OutOfBounds or EMPTY tile
 bool Chess::CheckValidPieceSelected(int n_input, int m_input) const {
 	if (!CheckOutOfBounds(n_input, m_input)) {
-		return (array_ptr_[n_input][m_input].piece_type != ChessPiece::EMPTY);
+		return (TileAt(n_input, m_input).Piece() != ChessPiece::EMPTY);
 	}
 	cout << "Invalid piece selected" << endl;
 	return false;
@@ -366,7 +299,7 @@ bool Chess::CheckValidPieceSelected(int n_input, int m_input) const {
 
 // Can't move black pieces at whites turn
 bool Chess::CheckCorrectTurnSequence(int n_input, int m_input) const {
-	if (array_ptr_[n_input][m_input].piece_team == ChessTeam::WHITE) {
+	if (TileAt(n_input, m_input).Team() == ChessTeam::WHITE) {
 		return is_whites_move_;
 	}
 	else {
@@ -384,7 +317,7 @@ bool Chess::CheckLegalPieceMove(int n_input, int m_input, int n_dest, int m_dest
 	if (CheckOutOfBounds(n_dest, m_dest)) {
 		return false;
 	}
-	const BoardTile& piece = array_ptr_[n_input][m_input];
+	const BoardTile piece = TileAt(n_input, m_input);
 	switch (piece.piece_type) {
 	default:
 		std::cout << "No chess pieces at that position"s << endl;
@@ -438,7 +371,7 @@ bool Chess::CheckLegalPieceMove(int n_input, int m_input, int n_dest, int m_dest
 			max_dif_n = piece.has_moved ? -1 : -2;
 		}
 		int8_t pos_dif_m = 0;
-		if (array_ptr_[n_dest][m_dest].piece_type != ChessPiece::EMPTY || 
+		if (TileAt(n_dest, m_dest).Piece() != ChessPiece::EMPTY || 
 			(en_passant_.first && n_dest == en_passant_.second.first && m_dest == en_passant_.second.second)) {
 			pos_dif_m = 1;
 			max_dif_n = (max_dif_n > 0) ? 1 : -1;
@@ -454,8 +387,8 @@ bool Chess::CheckLegalPieceMove(int n_input, int m_input, int n_dest, int m_dest
 // Collision with pieces in the path of movement
 // Expected to run after CheckValidPieceSelected() and CheckLegalPieceMove()
 bool Chess::CheckCollision(int n_input, int m_input, int n_dest, int m_dest) const {
-	const BoardTile& piece_input = array_ptr_[n_input][m_input];
-	const BoardTile& dest_tile = array_ptr_[n_dest][m_dest];
+	const BoardTile piece_input = TileAt(n_input, m_input);
+	const BoardTile dest_tile = TileAt(n_dest, m_dest);
 	if (dest_tile.piece_team == piece_input.piece_team) {
 		return true;
 	}
@@ -470,7 +403,7 @@ bool Chess::CheckCollision(int n_input, int m_input, int n_dest, int m_dest) con
 		int pos1 = n_input + increment_n;
 		int pos2 = m_input + increment_m;
 		while (pos1 != n_dest) {
-			if (array_ptr_[pos1][pos2].piece_type != ChessPiece::EMPTY) {
+			if (TileAt(pos1, pos2).Piece() != ChessPiece::EMPTY) {
 				return true;
 			}
 			pos1 += increment_n;
@@ -493,7 +426,7 @@ bool Chess::CheckCollision(int n_input, int m_input, int n_dest, int m_dest) con
 		int pos1 = n_input + increment_n;
 		int pos2 = m_input + increment_m;
 		while (pos1 != n_dest || pos2 != m_dest) {
-			if (array_ptr_[pos1][pos2].piece_type != ChessPiece::EMPTY) {
+			if (TileAt(pos1, pos2).Piece() != ChessPiece::EMPTY) {
 				return true;
 			}
 			pos1 += increment_n;
@@ -514,7 +447,7 @@ bool Chess::CheckCollision(int n_input, int m_input, int n_dest, int m_dest) con
 		int pos1 = n_input + increment_n;
 		int pos2 = m_input + increment_m;
 		while (pos1 != n_dest || pos2 != m_dest) {
-			if (array_ptr_[pos1][pos2].piece_type != ChessPiece::EMPTY) {
+			if (TileAt(pos1, pos2).Piece() != ChessPiece::EMPTY) {
 				return true;
 			}
 			pos1 += increment_n;
@@ -528,7 +461,7 @@ bool Chess::CheckCollision(int n_input, int m_input, int n_dest, int m_dest) con
 			int pos1 = n_input;
 			while (pos1 != n_dest) {
 				pos1 += increment_n;
-				if (array_ptr_[pos1][m_dest].piece_type != ChessPiece::EMPTY) {
+				if (TileAt(pos1, m_dest).Piece() != ChessPiece::EMPTY) {
 					return true;
 				}
 			}
@@ -539,80 +472,71 @@ bool Chess::CheckCollision(int n_input, int m_input, int n_dest, int m_dest) con
 
 // Finds if a king of a specified team is checked
 bool Chess::IsCheck(ChessTeam team) const {
-	std::pair<int, int> king_pos;
-	bool king_found = false;
-	for (int row = 0; row != rows_ && !king_found; ++row) { // Find king of specified team on the board
-		for (int column = 0; column != columns_ && !king_found; ++column) {
-			if (array_ptr_[row][column].piece_team == team &&
-				array_ptr_[row][column].piece_type == ChessPiece::KING) {
-
-				king_pos = { row, column };
-				king_found = true;
-			}
-		}
-	}
-	team = (team == ChessTeam::WHITE) ? ChessTeam::BLACK : ChessTeam::WHITE;
-	for (int row = 0; row != rows_; ++row) { // Check if any opposing team's piece can capture the king
-		for (int column = 0; column != columns_; ++column) {
-			if (array_ptr_[row][column].piece_team == team &&
-				CheckLegalPieceMove(row, column, king_pos.first, king_pos.second) && 
-				!CheckCollision(row, column, king_pos.first, king_pos.second)) {
-
-				if (array_ptr_[row][column].piece_type == ChessPiece::KING && std::abs(column - king_pos.second) == 2) {
-					continue;
-				}
-				return true;
-			}
-		}
-	}
-	return false;
-}
-
-// Run after CheckLegalPieceMove() for castling
-// King must be at input position
-bool Chess::CastlingCheckRequirements(int n_in, int m_in, int n_dest, int m_dest) const {
-	if (array_ptr_[n_in][m_in].has_moved || IsCheck(array_ptr_[n_in][m_in].piece_team)) {
-		return false;
-	}
-	int increment_m = (m_in > m_dest) ? -1 : 1;
-	BoardTile rook;
-	int pos = m_in + increment_m;
-	for (; !CheckOutOfBounds(n_in, pos); pos += increment_m) {
-		if (array_ptr_[n_in][pos].piece_type == ChessPiece::ROOK) {
-			rook = array_ptr_[n_in][pos];
-			break;
-		}
-		if (array_ptr_[n_in][pos].piece_type != ChessPiece::EMPTY) {
-			break;
-		}
-	}
-	if (rook.piece_type != ChessPiece::ROOK || rook.has_moved) {
+	if (team == ChessTeam::NEUTRAL || king_squares_[int(team)] < 0) {
 		return false;
 	}
+	return AttackCount((team == ChessTeam::WHITE) ? ChessTeam::BLACK : ChessTeam::WHITE, king_squares_[int(team)]) > 0;
+}
 
-	array_ptr_[n_in][pos] = { ChessPiece::EMPTY, ChessTeam::NEUTRAL, false };
-	if (array_ptr_[n_dest][m_dest].piece_type != ChessPiece::EMPTY) {
-		array_ptr_[n_in][pos] = rook;
-		return false;
-	}
-	BoardTile king = array_ptr_[n_in][m_in]; // Puts king into tiles in path of movement and sees if there is a check
-	array_ptr_[n_in][m_in] = { ChessPiece::EMPTY, ChessTeam::NEUTRAL, false };
-	array_ptr_[n_in][m_in + increment_m] = king;
-	if (IsCheck(king.piece_team)) { // If check, return the board to the previous state
-		array_ptr_[n_in][m_in + increment_m] = { ChessPiece::EMPTY, ChessTeam::NEUTRAL, false };
-		array_ptr_[n_in][pos] = rook;
-		array_ptr_[n_in][m_in] = king;
-		return false;
-	}
-	array_ptr_[n_in][m_in + increment_m] = { ChessPiece::EMPTY, ChessTeam::NEUTRAL, false };
-	array_ptr_[n_in][m_in + 2 * increment_m] = king;
-	bool output = true;
-	if (IsCheck(king.piece_team)) {
-		output = false;
+// Expects matching tile count, storage_ of *this must already be allocated
+void Chess::CopyState(const Chess& source) {
+	std::memcpy(storage_, source.storage_, GetStorageSize());
+	geometry_ = source.geometry_;
+	std::copy(std::begin(source.team_bitboards_), std::end(source.team_bitboards_), team_bitboards_);
+	std::copy(std::begin(source.piece_bitboards_), std::end(source.piece_bitboards_), piece_bitboards_);
+	std::copy(std::begin(source.king_squares_), std::end(source.king_squares_), king_squares_);
+	std::copy(std::begin(source.king_counts_), std::end(source.king_counts_), king_counts_);
+	std::copy(std::begin(source.piece_counts_), std::end(source.piece_counts_), piece_counts_);
+	std::copy(std::begin(source.material_), std::end(source.material_), material_);
+	std::memcpy(square_scores_, source.square_scores_, sizeof(square_scores_));
+	phase_ = source.phase_;
+	en_passant_ = source.en_passant_;
+	pawn_promotion_ = source.pawn_promotion_;
+	is_whites_move_ = source.is_whites_move_;
+	zobrist_key_ = source.zobrist_key_;
+	pawn_key_ = source.pawn_key_;
+	if (tile_observer_ != nullptr) {
+		tile_observer_->OnBoardRebuilt();
 	}
-	array_ptr_[n_in][m_in + 2 * increment_m] = { ChessPiece::EMPTY, ChessTeam::NEUTRAL, false };
-	array_ptr_[n_in][pos] = rook;
-	array_ptr_[n_in][m_in] = king;
-	return output;
 }
 
+// Expects *this to hold no heap buffer
+void Chess::TakeOver(Chess& source) noexcept {
+	rows_ = source.rows_;
+	columns_ = source.columns_;
+	geometry_ = source.geometry_;
+	if (source.storage_ != source.inline_storage_) {
+		storage_ = source.storage_;
+	}
+	else {
+		storage_ = inline_storage_;
+		std::memcpy(inline_storage_, source.inline_storage_, GetStorageSize());
+	}
+	BindStorage();
+	std::copy(std::begin(source.team_bitboards_), std::end(source.team_bitboards_), team_bitboards_);
+	std::copy(std::begin(source.piece_bitboards_), std::end(source.piece_bitboards_), piece_bitboards_);
+	std::copy(std::begin(source.king_squares_), std::end(source.king_squares_), king_squares_);
+	std::copy(std::begin(source.king_counts_), std::end(source.king_counts_), king_counts_);
+	std::copy(std::begin(source.piece_counts_), std::end(source.piece_counts_), piece_counts_);
+	std::copy(std::begin(source.material_), std::end(source.material_), material_);
+	std::memcpy(square_scores_, source.square_scores_, sizeof(square_scores_));
+	phase_ = source.phase_;
+	en_passant_ = source.en_passant_;
+	pawn_promotion_ = source.pawn_promotion_;
+	is_whites_move_ = source.is_whites_move_;
+	zobrist_key_ = source.zobrist_key_;
+	pawn_key_ = source.pawn_key_;
+	source.storage_ = source.inline_storage_;
+	source.rows_ = 0;
+	source.columns_ = 0;
+	source.BindStorage();
+	std::fill(std::begin(source.king_squares_), std::end(source.king_squares_), -1);
+	std::fill(std::begin(source.king_counts_), std::end(source.king_counts_), 0);
+	std::fill(std::begin(source.piece_counts_), std::end(source.piece_counts_), 0);
+	std::fill(std::begin(source.material_), std::end(source.material_), 0);
+	std::memset(source.square_scores_, 0, sizeof(source.square_scores_));
+	source.phase_ = 0;
+	if (tile_observer_ != nullptr) {
+		tile_observer_->OnBoardRebuilt();
+	}
+}
\ No newline at end of file
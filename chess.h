@@ -1,9 +1,16 @@
 #pragma once
 
+#include "bitboard.h"
+#include "board_geometry.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <deque>
+#include <iterator>
 #include <tuple>
 
-enum class ChessPiece {
+enum class ChessPiece : uint8_t {
 	EMPTY,
 
 	PAWN,
@@ -14,7 +21,7 @@ enum class ChessPiece {
 	KING
 };
 
-enum class ChessTeam {
+enum class ChessTeam : uint8_t {
 	NEUTRAL,
 
 	WHITE,
@@ -27,25 +34,307 @@ struct BoardTile {
 	bool has_moved = false;                   // Important to know for pawn moves and potential for castling
 };
 
+// One byte form of BoardTile used for board storage
+// Bits 0-2 hold piece type, bits 3-4 team and bit 5 has_moved
+class PackedTile {
+public:
+	constexpr PackedTile() = default;
+
+	constexpr PackedTile(ChessPiece piece, ChessTeam team, bool has_moved) :
+		bits_(uint8_t(uint8_t(piece) | (uint8_t(team) << TEAM_SHIFT) | (has_moved ? MOVED_BIT : 0))) {}
+
+	constexpr PackedTile(const BoardTile& tile) : PackedTile(tile.piece_type, tile.piece_team, tile.has_moved) {}
+
+	constexpr operator BoardTile() const {
+		return { Piece(), Team(), HasMoved() };
+	}
+
+	constexpr ChessPiece Piece() const {
+		return ChessPiece(bits_ & PIECE_MASK);
+	}
+
+	constexpr ChessTeam Team() const {
+		return ChessTeam((bits_ >> TEAM_SHIFT) & TEAM_MASK);
+	}
+
+	constexpr bool HasMoved() const {
+		return bits_ & MOVED_BIT;
+	}
+
+	constexpr bool operator==(const PackedTile& other) const = default;
+
+	void SetPiece(ChessPiece piece) {
+		bits_ = uint8_t((bits_ & ~PIECE_MASK) | uint8_t(piece));
+	}
+
+	void SetMoved() {
+		bits_ |= MOVED_BIT;
+	}
+
+private:
+	static constexpr uint8_t PIECE_MASK = 0b111;
+	static constexpr uint8_t TEAM_MASK = 0b11;
+	static constexpr uint8_t TEAM_SHIFT = 3;
+	static constexpr uint8_t MOVED_BIT = 1 << 5;
+
+	uint8_t bits_ = 0;
+};
+
+static_assert(sizeof(PackedTile) == 1, "PackedTile must stay one byte");
+
+// Four byte move, made by Chess::GenerateLegalMoves()
+// Tiles are row-major indices (row * columns + column)
+// Bits 0-12 hold the origin, 13-25 the destination, 26-28 the promotion piece (EMPTY if none),
+// bit 29 marks captures, 30 en passant and 31 castling
+class Move {
+public:
+	static constexpr int SQUARE_BITS = 13;
+	static constexpr uint32_t CAPTURE = uint32_t(1) << 29;
+	static constexpr uint32_t EN_PASSANT = uint32_t(1) << 30;
+	static constexpr uint32_t CASTLING = uint32_t(1) << 31;
+
+	constexpr Move() = default;
+
+	constexpr Move(int from, int to, ChessPiece promotion = ChessPiece::EMPTY, uint32_t flags = 0) :
+		bits_(uint32_t(from) | (uint32_t(to) << SQUARE_BITS) | (uint32_t(promotion) << PROMOTION_SHIFT) | flags) {}
+
+	constexpr int From() const {
+		return int(bits_ & SQUARE_MASK);
+	}
+
+	constexpr int To() const {
+		return int((bits_ >> SQUARE_BITS) & SQUARE_MASK);
+	}
+
+	constexpr ChessPiece Promotion() const {
+		return ChessPiece((bits_ >> PROMOTION_SHIFT) & PIECE_MASK);
+	}
+
+	constexpr bool IsPromotion() const {
+		return Promotion() != ChessPiece::EMPTY;
+	}
+
+	// En passant counts as a capture too
+	constexpr bool IsCapture() const {
+		return bits_ & CAPTURE;
+	}
+
+	constexpr bool IsEnPassant() const {
+		return bits_ & EN_PASSANT;
+	}
+
+	constexpr bool IsCastling() const {
+		return bits_ & CASTLING;
+	}
+
+	// CAPTURE, EN_PASSANT and CASTLING bits
+	constexpr uint32_t Flags() const {
+		return bits_ & (CAPTURE | EN_PASSANT | CASTLING);
+	}
+
+	constexpr bool operator==(const Move& other) const = default;
+
+private:
+	static constexpr uint32_t SQUARE_MASK = (uint32_t(1) << SQUARE_BITS) - 1;
+	static constexpr int PROMOTION_SHIFT = 2 * SQUARE_BITS;
+	static constexpr uint32_t PIECE_MASK = 0b111;
+
+	uint32_t bits_ = 0;
+};
+
+static_assert(sizeof(Move) == 4, "Move must stay four bytes");
+
+// Part of the legal moves Chess::GenerateLegalMoves() gives
+// CAPTURES holds captures (en passant included) and all promotions, QUIETS every other move
+enum class MoveKind : uint8_t {
+	ALL,
+	CAPTURES,
+	QUIETS
+};
+
+// Move list for Chess::GenerateLegalMoves(), meant to be kept and refilled
+// Up to INLINE_MOVES moves live inside the object. A longer list (big boards only) moves to a heap block,
+// which is kept for later use
+class MoveBuffer {
+public:
+	static constexpr size_t INLINE_MOVES = 256;
+
+	MoveBuffer() = default;
+
+	MoveBuffer(const MoveBuffer&) = delete;
+
+	MoveBuffer& operator=(const MoveBuffer&) = delete;
+
+	~MoveBuffer() {
+		if (moves_ != inline_moves_) {
+			delete[] moves_;
+		}
+	}
+
+	void clear() {
+		size_ = 0;
+	}
+
+	void push_back(Move move) {
+		if (size_ == capacity_) {
+			Grow();
+		}
+		moves_[size_++] = move;
+	}
+
+	size_t size() const {
+		return size_;
+	}
+
+	bool empty() const {
+		return size_ == 0;
+	}
+
+	Move operator[](size_t index) const {
+		return moves_[index];
+	}
+
+	Move& operator[](size_t index) {
+		return moves_[index];
+	}
+
+	const Move* begin() const {
+		return moves_;
+	}
+
+	const Move* end() const {
+		return moves_ + size_;
+	}
+
+	Move* begin() {
+		return moves_;
+	}
+
+	Move* end() {
+		return moves_ + size_;
+	}
+
+private:
+	Move inline_moves_[INLINE_MOVES];
+	Move* moves_ = inline_moves_;
+	size_t size_ = 0;
+	size_t capacity_ = INLINE_MOVES;
+
+	void Grow() {
+		Move* moves = new Move[capacity_ * 2];
+		std::copy(moves_, moves_ + size_, moves);
+		if (moves_ != inline_moves_) {
+			delete[] moves_;
+		}
+		moves_ = moves;
+		capacity_ *= 2;
+	}
+};
+
+// Read-only view of the tiles that hold pieces of one team, in no particular order
+// Points into the board, so it is valid until the board changes
+class PieceList {
+public:
+	class Iterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = std::pair<int, int>;
+		using difference_type = std::ptrdiff_t;
+		using pointer = void;
+		using reference = std::pair<int, int>;
+
+		Iterator() = default;
+
+		Iterator(const uint16_t* square, int columns) : square_(square), columns_(columns) {}
+
+		std::pair<int, int> operator*() const {
+			return { *square_ / columns_, *square_ % columns_ };
+		}
+
+		Iterator& operator++() {
+			++square_;
+			return *this;
+		}
+
+		Iterator operator++(int) {
+			Iterator previous = *this;
+			++square_;
+			return previous;
+		}
+
+		bool operator==(const Iterator& other) const {
+			return square_ == other.square_;
+		}
+
+	private:
+		const uint16_t* square_ = nullptr;
+		int columns_ = 1;
+	};
+
+	PieceList(const uint16_t* begin, const uint16_t* end, int columns) : begin_(begin), end_(end), columns_(columns) {}
+
+	Iterator begin() const {
+		return { begin_, columns_ };
+	}
+
+	Iterator end() const {
+		return { end_, columns_ };
+	}
+
+	size_t size() const {
+		return size_t(end_ - begin_);
+	}
+
+	bool empty() const {
+		return begin_ == end_;
+	}
+
+	std::pair<int, int> operator[](size_t index) const {
+		return { begin_[index] / columns_, begin_[index] % columns_ };
+	}
+
+private:
+	const uint16_t* begin_ = nullptr;
+	const uint16_t* end_ = nullptr;
+	int columns_ = 1;
+};
+
+// Told about every change of the board it watches, see Chess::SetTileObserver()
+// Meant for state kept outside the board that follows it move by move, e.g. the first layer of a network
+class TileObserver {
+public:
+	virtual ~TileObserver() = default;
+
+	// A tile changed from previous to tile, the board already holds the new tile
+	// During a move the board passes through positions that are not legal, e.g. with a king lifted off
+	virtual void OnTileChanged(int square, PackedTile previous, PackedTile tile) = 0;
+
+	// The whole board was replaced at once: filled, emptied or assigned to
+	virtual void OnBoardRebuilt() = 0;
+};
+
 class Chess {
 public:
 
 	// Board has matrix-like dimensions of (n x m), where an element of 1x1 board has coordinates (0, 0)
+	// A Move holds tiles in 13 bits, so a board holds at most MAX_TILES of them. Throws std::invalid_argument
+	// for a bigger one
 	Chess(int n, int m);
 
 	// Classic game of chess piece setup
 	Chess();
 
-	// Creates a copy of a board state and stores it in newly allocated memory
-	// array_ptr_ will be unique
+	// Creates a copy of a board state with a single memcpy of the board buffer
+	// storage_ will be unique
 	Chess(const Chess& source);
 
+	// Heap buffers are stolen, inline ones are copied. Source is left as an empty 0x0 board
 	Chess(Chess&& source) noexcept;
 
 	// Copies board state. Previous state of *this is destroyed
 	Chess& operator=(const Chess& source);
 
-	// Essentially swaps contents
+	// Same as the move constructor, previous state of *this is destroyed
 	Chess& operator=(Chess&& source) noexcept;
 
 	virtual ~Chess() {
@@ -69,6 +358,30 @@ public:
 	// If used after GetPossibleTiles(), avoids redundancy
 	void ForceMove(std::pair<int, int> input_pos, std::pair<int, int> output_pos);
 
+	// What MakeMove() overwrites that the move itself doesn't tell
+	struct UndoInfo {
+		PackedTile moved;                      // Piece as it stood on the origin tile
+		PackedTile captured;
+		int captured_square = -1;              // Differs from the destination for en passant, -1 for castling
+		PackedTile rook;                       // Castling only
+		int rook_square = -1;
+		std::pair<bool, std::pair<int, int>> en_passant;
+		std::pair<bool, std::pair<int, int>> pawn_promotion;
+	};
+
+	// Makes a move given by GenerateLegalMoves() for this position, no rule checks
+	// A promotion piece is placed right away, a promoting move without one leaves PawnPromotion() pending
+	UndoInfo MakeMove(Move move);
+
+	// Takes back the last MakeMove(). Tiles, turn, en passant, promotion and all derived state are restored,
+	// only the order of GetPieces() may differ
+	void UnmakeMove(Move move, const UndoInfo& undo);
+
+	// Passes the turn without moving, as null-move pruning of a search needs. En passant is dropped
+	UndoInfo MakeNullMove();
+
+	void UnmakeNullMove(const UndoInfo& undo);
+
 	// Does all the necessary checks, moves a piece and returns 'true'
 	// Or does nothing and returns 'false' if the move is illegal
 	virtual bool MovePiece(std::pair<int, int> input_pos, std::pair<int, int> dest_pos);
@@ -89,11 +402,149 @@ public:
 
 	void SwitchTurnSequence();
 
+	// 64-bit Zobrist key of the position: tiles, side to move, castling state (has_moved of kings and rooks)
+	// and en passant column. Kept up to date on every change of the board, equal positions of one board size
+	// have equal keys
+	uint64_t GetZobristKey() const {
+		return zobrist_key_;
+	}
+
+	// Zobrist key of the pawns alone (team and tile, has_moved left out), 0 without pawns
+	// Kept up to date on every change of the board, boards with equal pawns have equal keys
+	uint64_t GetPawnKey() const {
+		return pawn_key_;
+	}
+
+	// Is a tile attacked by at least one piece of 'attacker', out of bounds tiles never are
+	// Answered from attack maps that are kept up to date on every change of the board
+	bool IsSquareAttacked(ChessTeam attacker, int row, int column) const;
+
+	// Tiles holding pieces of a team, kept up to date on every change of the board. NEUTRAL pieces are not listed
+	PieceList GetPieces(ChessTeam team) const;
+
+	// Is the king of the side to move attacked
+	bool IsInCheck() const {
+		return IsCheck(WhoseMove());
+	}
+
+	// Does a team have a piece other than pawns and kings. Without one, passing the turn is often its best
+	// option (zugzwang), which null-move pruning must not assume away
+	bool HasPiecesBeyondPawns(ChessTeam team) const;
+
+	// Pawn 1, knight and bishop 3, rook 5, queen 9. Kings and empty tiles are worth nothing
+	static constexpr int PieceValue(ChessPiece piece) {
+		switch (piece) {
+		case ChessPiece::PAWN:
+			return 1;
+		case ChessPiece::KNIGHT:
+		case ChessPiece::BISHOP:
+			return 3;
+		case ChessPiece::ROOK:
+			return 5;
+		case ChessPiece::QUEEN:
+			return 9;
+		default:
+			return 0;
+		}
+	}
+
+	// Static exchange evaluation: PieceValue() units a move wins on its destination once both teams have
+	// recaptured there with their cheapest pieces, each free to stop when further captures would lose
+	// Pieces lined up behind an attacker join in after it (x-rays). Pins are ignored and a king only captures
+	// onto a tile the other team no longer reaches. Negative for a losing capture, 0 or less for a quiet move
+	int StaticExchange(Move move) const;
+
+	// Sum of PieceValue() over the pieces of a team, promotions included
+	// Kept up to date on every change of the board, so reading it costs no scan
+	int GetMaterial(ChessTeam team) const {
+		return material_[int(team)];
+	}
+
+	// How much a piece counts towards the middlegame: knight and bishop 1, rook 2, queen 4
+	static constexpr int PhaseWeight(ChessPiece piece) {
+		switch (piece) {
+		case ChessPiece::KNIGHT:
+		case ChessPiece::BISHOP:
+			return 1;
+		case ChessPiece::ROOK:
+			return 2;
+		case ChessPiece::QUEEN:
+			return 4;
+		default:
+			return 0;
+		}
+	}
+
+	// GetPhase() of the standard setup. From it on the game counts as middlegame, at 0 as endgame
+	static constexpr int FULL_PHASE = 24;
+
+	// Sum of PhaseWeight() over the pieces of both teams, kept up to date on every change of the board
+	int GetPhase() const {
+		return phase_;
+	}
+
+	// Sum of BoardGeometry::SquareScore() over the pieces of a team in one phase (0 middlegame, 1 endgame)
+	// Kept up to date on every change of the board
+	int GetSquareScore(ChessTeam team, int phase) const {
+		return square_scores_[phase][int(team)];
+	}
+
+	// At most one observer at a time, nullptr removes it. The observer is not copied or moved with the board
+	// and must outlive its watch
+	void SetTileObserver(TileObserver* observer) {
+		tile_observer_ = observer;
+	}
+
+	static constexpr int MAX_TILES = 1 << Move::SQUARE_BITS;
+
+	// Every legal move of the side to move, replaces the previous content of 'moves'
+	// Moves are ordered by origin, then destination tile (row-major). Each promoting pawn move comes
+	// four times: queen, knight, bishop, rook
+	// 'kind' limits the moves to captures or quiet moves, so a search can generate them one group at a time
+	void GenerateLegalMoves(MoveBuffer& moves, MoveKind kind = MoveKind::ALL) const;
+
+	// Would GenerateLegalMoves() give this move, flags and promotion piece included
+	// Meant for moves kept from other positions, e.g. killer moves of a search
+	bool IsMoveLegal(Move move) const;
+
 private:
-	BoardTile** array_ptr_ = nullptr;
+	// Boards up to 8x8 are stored inside the object, so copying them needs no allocation
+	static constexpr int INLINE_TILES = 64;
+	// Tile itself, the number of white and black pieces attacking it, its slot in piece_list_
+	// and one slot of piece_list_
+	static constexpr int BYTES_PER_TILE = 3 + 2 * sizeof(uint16_t);
+
+	// Per-tile data in one buffer, either inline_storage_ or a single heap block
+	// Layout: [piece_slots_][piece_list_][tiles_][attack counts of white][attack counts of black], see BindStorage()
+	unsigned char* storage_ = inline_storage_;
+	alignas(uint16_t) unsigned char inline_storage_[INLINE_TILES * BYTES_PER_TILE] = {};
+	PackedTile* tiles_ = nullptr;
+	uint8_t* attack_counts_ = nullptr;
+	// Squares of white pieces fill piece_list_ from the front, those of black pieces from the back
+	// piece_slots_[square] is the position of an occupied square in piece_list_
+	uint16_t* piece_list_ = nullptr;
+	uint16_t* piece_slots_ = nullptr;
 	int rows_ = 0;
 	int columns_ = 0;
+	// Ray and jump tables shared by all boards of this size
+	const BoardGeometry* geometry_ = nullptr;
 	bool is_whites_move_ = true;
+	uint64_t zobrist_key_ = 0;
+	uint64_t pawn_key_ = 0;
+
+	// Mirror tiles_ on the standard 8x8 board and stay empty otherwise
+	// Indexed by ChessTeam / ChessPiece, EMPTY and NEUTRAL entries are unused
+	Bitboard team_bitboards_[3] = {};
+	Bitboard piece_bitboards_[7] = {};
+
+	// Indexed by ChessTeam. Square of the first king of a team in row-major order or -1
+	int king_squares_[3] = { -1, -1, -1 };
+	int king_counts_[3] = {};
+	int piece_counts_[3] = {};
+	int material_[3] = {};
+	int square_scores_[BoardGeometry::PHASE_COUNT][3] = {};
+	int phase_ = 0;
+	TileObserver* tile_observer_ = nullptr;
 	
 	// En passant { has a pawn moved two tiles ahead previous turn, { coordinates }}
 	std::pair<bool, std::pair<int, int>> en_passant_ = { false, { 0, 0 } };
@@ -122,15 +573,172 @@ private:
 	// Finds if a king of a specified team is checked
 	bool IsCheck(ChessTeam team) const;
 
-	// Run after CheckLegalPieceMove() for castling
-	// King must be at input position
-	bool CastlingCheckRequirements(int n_in, int m_in, int n_dest, int m_dest) const;
+	// Checks and pins against the king of a team, found once per position
+	// Move legality is then decided without trial moves on the board
+	struct KingSafety {
+		int king_square = -1;                        // -1 if the team has no king
+		int checker_count = 0;
+		int checker_square = -1;                     // Last checker found
+		int check_ray = -1;                          // Ray from king to a sliding checker, -1 otherwise
+		int check_distance = 0;
+		int pin_count = 0;
+		int pinned_squares[BoardGeometry::RAY_COUNT] = {};
+		int pin_rays[BoardGeometry::RAY_COUNT] = {}; // Ray from king through the pinned piece
+		uint8_t xray_rays = 0;                       // Bit r is set if a sliding checker also hits the tile next to the king along ray r
+		Bitboard check_mask = ~Bitboard(0);          // Bitboard path only. Captures and blocks that answer a check
+		Bitboard pinned = 0;                         // Bitboard path only
+	};
+
+	KingSafety ComputeKingSafety(ChessTeam team) const;
+
+	// Full rule check of a move for the piece at square 'from', turn sequence aside
+	bool IsLegalMove(int from, int n_dest, int m_dest) const;
+
+	// Expects dest to be a pseudo target of the piece at 'from', see ForEachPseudoTarget()
+	bool IsLegalPseudoMove(const KingSafety& safety, int from, int dest) const;
+
+	// For moves of pieces other than the king, en passant aside
+	bool KeepsKingSafe(const KingSafety& safety, int from, int dest) const;
+
+	// Returns k if square = origin + k * (ray offset) for some k > 0, otherwise 0
+	int RayDistance(int origin, int ray, int square) const;
+
+	// King at king_square moves two tiles towards dest_square, the first rook in that direction jumps over it
+	// Neither may have moved, tiles between them must be empty and the king can't be checked on its path
+	bool CastlingAllowed(int king_square, int dest_square) const;
+
+	// Walks rays and knight jumps outwards from a square looking for pieces of a team that reach it
+	// Tiles 'vacated' and 'vacated_other' are treated as empty, tile 'filled' as blocked by a non-attacker
+	bool IsAttackedBy(ChessTeam attacker, int square, int vacated = -1, int vacated_other = -1, int filled = -1) const;
+
+	// Square of the cheapest piece of 'attacker' that reaches square, -1 if none
+	// Tiles listed in 'removed' are treated as empty, which lets pieces behind them through
+	int CheapestAttacker(ChessTeam attacker, int square, const int* removed, int removed_count) const;
+
+	// Calls visit(dest_square) for every tile a piece at square can reach by its movement rules
+	// Own king safety is not checked. Castling destinations are given without checking castling requirements
+	template <typename Visitor>
+	void ForEachPseudoTarget(int square, Visitor&& visit) const;
+
+	// Bitboard backend, used automatically for 8x8 boards (chess_bitboard.cpp)
+	bool HasBitboards() const {
+		return rows_ == BITBOARD_SIDE && columns_ == BITBOARD_SIDE;
+	}
+
+	void RebuildBitboards();
+
+	// Pieces of both teams that attack a square, given custom occupancy
+	Bitboard AttackersTo(int square, Bitboard occupied) const;
+
+	// Can the king of a team standing at king_square be captured
+	// Pieces at 'removed' are treated as gone, occupancy is given explicitly
+	bool IsKingAttacked(ChessTeam team, int king_square, Bitboard occupied, Bitboard removed) const;
+
+	KingSafety BitboardKingSafety(ChessTeam team) const;
+
+	// Same rules as CastlingAllowed()
+	bool BitboardCastlingAllowed(int king_square, int dest_square) const;
+
+	// All legal destinations for a piece at square
+	Bitboard BitboardLegalTargets(int square, const KingSafety& safety) const;
+
+	// Every change of the board goes through here (chess_incremental.cpp)
+	// Keeps bitboards, king squares, piece lists and attack maps in line with tiles_
+	void PlaceTile(int square, PackedTile tile);
+
+	void PlaceTile(int row, int column, PackedTile tile) {
+		PlaceTile(row * columns_ + column, tile);
+	}
+
+	// Flags a move from one tile to another would get from GenerateLegalMoves(), without a promotion piece
+	Move DescribeMove(int from, int dest) const;
+
+	// Recomputes everything PlaceTile() maintains from tiles_ alone, the Zobrist key from the whole position
+	void RebuildIncrementalState();
+
+	uint64_t TileKey(int square, PackedTile tile) const {
+		return geometry_->TileKey(square, uint8_t(tile.Team()), uint8_t(tile.Piece()), tile.HasMoved());
+	}
+
+	int SquareScore(int phase, int square, PackedTile tile) const {
+		return geometry_->SquareScore(phase, square, uint8_t(tile.Team()), uint8_t(tile.Piece()));
+	}
+
+	// Part of the pawn key a tile gives, 0 for anything but a pawn
+	uint64_t PawnKey(int square, PackedTile tile) const {
+		if (tile.Piece() != ChessPiece::PAWN) {
+			return 0;
+		}
+		return geometry_->TileKey(square, uint8_t(tile.Team()), uint8_t(tile.Piece()), false);
+	}
+
+	// Zobrist key of the position from scratch
+	uint64_t ComputeZobristKey() const;
+
+	// Turn changes go through here to keep the Zobrist key
+	void FlipTurn() {
+		is_whites_move_ = !is_whites_move_;
+		zobrist_key_ ^= geometry_->SideKey();
+	}
+
+	// Adds delta to the attack count of every tile the piece at square attacks
+	void AddPieceAttacks(int square, PackedTile piece, int delta);
+
+	// Sliders aiming at a square reach past it once it empties (delta = 1) and stop at it once it fills (delta = -1)
+	void ShadeRaysThrough(int square, int delta);
+
+	void TrackKing(int square, PackedTile piece, bool is_placed);
+
+	// Expects square to hold a piece of team
+	void AddToPieceList(ChessTeam team, int square);
+
+	void RemoveFromPieceList(ChessTeam team, int square);
+
+	// [first, last) of the piece_list_ part holding a team
+	std::pair<const uint16_t*, const uint16_t*> PieceSquares(ChessTeam team) const;
+
+	// Appends a legal move with its flags, or all four promotions of it
+	void AddLegalMove(MoveBuffer& moves, int from, int dest) const;
+
+	// Does a move from one tile to another belong to MoveKind::CAPTURES, the move itself is not checked
+	bool IsCaptureOrPromotion(int from, int dest) const;
+
+	// Expects team to be WHITE or BLACK
+	uint8_t AttackCount(ChessTeam team, int square) const {
+		return attack_counts_[(int(team) - 1) * GetTileCount() + square];
+	}
+
+	int GetTileCount() const {
+		return rows_ * columns_;
+	}
+
+	int GetStorageSize() const {
+		return GetTileCount() * BYTES_PER_TILE;
+	}
+
+	// Points the per-tile arrays into storage_, 16 bit ones first to keep them aligned
+	void BindStorage() {
+		piece_slots_ = reinterpret_cast<uint16_t*>(storage_);
+		piece_list_ = piece_slots_ + GetTileCount();
+		tiles_ = reinterpret_cast<PackedTile*>(piece_list_ + GetTileCount());
+		attack_counts_ = reinterpret_cast<uint8_t*>(tiles_ + GetTileCount());
+	}
+
+	// Expects coordinates within bounds
+	PackedTile TileAt(int row, int column) const {
+		return tiles_[row * columns_ + column];
+	}
+
+	// Expects matching tile count, storage_ of *this must already be allocated
+	void CopyState(const Chess& source);
+
+	// Expects *this to hold no heap buffer
+	void TakeOver(Chess& source) noexcept;
 
 	void CleanUp() {
-		for (int i = 0; i < rows_; ++i) {
-			delete[] array_ptr_[i];
+		if (storage_ != inline_storage_) {
+			delete[] storage_;
 		}
-		delete[] array_ptr_;
-		array_ptr_ = nullptr;
+		storage_ = inline_storage_;
 	}
 };
\ No newline at end of file
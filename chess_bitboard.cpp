@@ -0,0 +1,257 @@
+#include "chess.h"
+#include "bitboard.h"
+#include "board_geometry.h"
+
+#include <algorithm>
+#include <iterator>
+
+// Bitboard backend of Chess, used automatically when the board is 8x8
+// Generic (n x m) boards use the ray walks in chess_movegen.cpp
+
+namespace {
+
+	ChessTeam EnemyTeam(ChessTeam team) {
+		return (team == ChessTeam::WHITE) ? ChessTeam::BLACK : ChessTeam::WHITE;
+	}
+
+	// Ray from one square through another, -1 if they are not aligned
+	int RayTowards(int from, int to) {
+		for (int ray = 0; ray < BoardGeometry::RAY_COUNT; ++ray) {
+			if (RayMask(from, ray) & SquareBit(to)) {
+				return ray;
+			}
+		}
+		return -1;
+	}
+
+	// Tiles strictly between two aligned squares along a ray from 'from'
+	Bitboard Between(int from, int to, int ray) {
+		return RayMask(from, ray) & ~RayMask(to, ray) & ~SquareBit(to);
+	}
+}
+
+void Chess::RebuildBitboards() {
+	std::fill(std::begin(team_bitboards_), std::end(team_bitboards_), 0);
+	std::fill(std::begin(piece_bitboards_), std::end(piece_bitboards_), 0);
+	if (!HasBitboards()) {
+		return;
+	}
+	for (int square = 0; square < BITBOARD_SQUARES; ++square) {
+		PackedTile tile = tiles_[square];
+		if (tile.Piece() != ChessPiece::EMPTY) {
+			team_bitboards_[int(tile.Team())] |= SquareBit(square);
+			piece_bitboards_[int(tile.Piece())] |= SquareBit(square);
+		}
+	}
+}
+
+// Pieces of both teams that attack a square, given custom occupancy
+Bitboard Chess::AttackersTo(int square, Bitboard occupied) const {
+	Bitboard pawns = piece_bitboards_[int(ChessPiece::PAWN)];
+	Bitboard queens = piece_bitboards_[int(ChessPiece::QUEEN)];
+	// A white pawn attacks the square from where a black pawn on it would attack, and vice versa
+	return (PawnAttacks(false, square) & pawns & team_bitboards_[int(ChessTeam::WHITE)]) |
+		(PawnAttacks(true, square) & pawns & team_bitboards_[int(ChessTeam::BLACK)]) |
+		(KnightAttacks(square) & piece_bitboards_[int(ChessPiece::KNIGHT)]) |
+		(KingAttacks(square) & piece_bitboards_[int(ChessPiece::KING)]) |
+		(RookAttacks(square, occupied) & (piece_bitboards_[int(ChessPiece::ROOK)] | queens)) |
+		(BishopAttacks(square, occupied) & (piece_bitboards_[int(ChessPiece::BISHOP)] | queens));
+}
+
+// Can the king of a team standing at king_square be captured
+// Pieces at 'removed' are treated as gone, occupancy is given explicitly
+bool Chess::IsKingAttacked(ChessTeam team, int king_square, Bitboard occupied, Bitboard removed) const {
+	Bitboard enemies = team_bitboards_[int(EnemyTeam(team))] & ~removed;
+	return (AttackersTo(king_square, occupied) & enemies) != 0;
+}
+
+// Same rules as CastlingAllowed()
+bool Chess::BitboardCastlingAllowed(int king_square, int dest_square) const {
+	PackedTile king = tiles_[king_square];
+	Bitboard occupied = team_bitboards_[int(ChessTeam::WHITE)] | team_bitboards_[int(ChessTeam::BLACK)];
+	if (king.HasMoved() || AttackCount(EnemyTeam(king.Team()), king_square) > 0) {
+		return false;
+	}
+	int row_start = king_square - king_square % BITBOARD_SIDE;
+	int increment = (dest_square > king_square) ? 1 : -1;
+	int rook_square = -1;
+	for (int pos = king_square + increment; pos >= row_start && pos < row_start + BITBOARD_SIDE; pos += increment) {
+		if (tiles_[pos].Piece() == ChessPiece::ROOK) {
+			rook_square = pos;
+			break;
+		}
+		if (tiles_[pos].Piece() != ChessPiece::EMPTY) {
+			break;
+		}
+	}
+	if (rook_square < 0 || tiles_[rook_square].HasMoved()) {
+		return false;
+	}
+
+	occupied &= ~(SquareBit(rook_square) | SquareBit(king_square));
+	if (occupied & SquareBit(dest_square)) {
+		return false;
+	}
+	// King can't pass through or land on an attacked tile
+	for (int path = king_square + increment; ; path += increment) {
+		if (IsKingAttacked(king.Team(), path, occupied | SquareBit(path), SquareBit(rook_square))) {
+			return false;
+		}
+		if (path == dest_square) {
+			return true;
+		}
+	}
+}
+
+Chess::KingSafety Chess::BitboardKingSafety(ChessTeam team) const {
+	KingSafety safety;
+	if (team == ChessTeam::NEUTRAL || king_squares_[int(team)] < 0) {
+		return safety;
+	}
+	safety.king_square = king_squares_[int(team)];
+	Bitboard own = team_bitboards_[int(team)];
+	Bitboard enemies = team_bitboards_[int(EnemyTeam(team))];
+	Bitboard occupied = own | enemies;
+
+	Bitboard checkers = AttackersTo(safety.king_square, occupied) & enemies;
+	safety.checker_count = CountSquares(checkers);
+	if (safety.checker_count == 1) {
+		safety.checker_square = LowestSquare(checkers);
+		int ray = RayTowards(safety.king_square, safety.checker_square);
+		safety.check_mask = checkers;
+		if (ray >= 0) {
+			safety.check_mask |= Between(safety.king_square, safety.checker_square, ray);
+		}
+	}
+	else if (safety.checker_count > 1) {
+		safety.check_mask = 0;
+	}
+	Bitboard queens = piece_bitboards_[int(ChessPiece::QUEEN)];
+	Bitboard sliding_checkers = checkers &
+		(piece_bitboards_[int(ChessPiece::ROOK)] | piece_bitboards_[int(ChessPiece::BISHOP)] | queens);
+	while (sliding_checkers) {
+		int ray = RayTowards(safety.king_square, PopLowestSquare(sliding_checkers));
+		safety.xray_rays |= uint8_t(1 << BoardGeometry::OppositeRay(ray));
+	}
+
+	// Enemy sliders that would see the king if own pieces were not in the way
+	Bitboard snipers = enemies & (
+		(RookAttacks(safety.king_square, enemies) & (piece_bitboards_[int(ChessPiece::ROOK)] | queens)) |
+		(BishopAttacks(safety.king_square, enemies) & (piece_bitboards_[int(ChessPiece::BISHOP)] | queens)));
+	while (snipers) {
+		int sniper = PopLowestSquare(snipers);
+		int ray = RayTowards(safety.king_square, sniper);
+		Bitboard blockers = Between(safety.king_square, sniper, ray) & occupied;
+		if (CountSquares(blockers) == 1 && (blockers & own)) {
+			safety.pinned |= blockers;
+			safety.pinned_squares[safety.pin_count] = LowestSquare(blockers);
+			safety.pin_rays[safety.pin_count] = ray;
+			++safety.pin_count;
+		}
+	}
+	return safety;
+}
+
+// All legal destinations for a piece at square
+Bitboard Chess::BitboardLegalTargets(int square, const KingSafety& safety) const {
+	PackedTile piece = tiles_[square];
+	ChessTeam team = piece.Team();
+	bool is_white = (team == ChessTeam::WHITE);
+	Bitboard own = team_bitboards_[int(team)];
+	Bitboard enemies = team_bitboards_[int(EnemyTeam(team))];
+	Bitboard occupied = own | enemies;
+	int row = square / BITBOARD_SIDE;
+	int column = square % BITBOARD_SIDE;
+
+	Bitboard targets = 0;
+	switch (piece.Piece()) {
+	default:
+		return 0;
+	case ChessPiece::KING:
+	{
+		Bitboard output = 0;
+		Bitboard steps = KingAttacks(square) & ~own;
+		if (square == safety.king_square) {
+			// Attack maps see everything but the tile the king hides from a sliding checker behind itself
+			for (int ray = 0; ray < BoardGeometry::RAY_COUNT; ++ray) {
+				if (safety.xray_rays & (1 << ray)) {
+					steps &= ~RayMask(square, ray);
+				}
+			}
+			ChessTeam enemy = EnemyTeam(team);
+			while (steps) {
+				int dest = PopLowestSquare(steps);
+				if (AttackCount(enemy, dest) == 0) {
+					output |= SquareBit(dest);
+				}
+			}
+		}
+		// Any other king is checked directly, lifted off the board
+		while (steps) {
+			int dest = PopLowestSquare(steps);
+			if (!IsKingAttacked(team, dest, (occupied & ~SquareBit(square)) | SquareBit(dest), SquareBit(dest))) {
+				output |= SquareBit(dest);
+			}
+		}
+		for (int dest_column : { column - 2, column + 2 }) {
+			if (dest_column >= 0 && dest_column < BITBOARD_SIDE &&
+				BitboardCastlingAllowed(square, square - column + dest_column)) {
+				output |= SquareBit(square - column + dest_column);
+			}
+		}
+		return output;
+	}
+	case ChessPiece::KNIGHT:
+		targets = KnightAttacks(square) & ~own;
+		break;
+	case ChessPiece::BISHOP:
+		targets = BishopAttacks(square, occupied) & ~own;
+		break;
+	case ChessPiece::ROOK:
+		targets = RookAttacks(square, occupied) & ~own;
+		break;
+	case ChessPiece::QUEEN:
+		targets = QueenAttacks(square, occupied) & ~own;
+		break;
+	case ChessPiece::PAWN:
+	{
+		int increment_n = is_white ? -1 : 1;
+		int one_step = row + increment_n;
+		if (one_step >= 0 && one_step < BITBOARD_SIDE && !(occupied & SquareBit(square + increment_n * BITBOARD_SIDE))) {
+			targets |= SquareBit(square + increment_n * BITBOARD_SIDE);
+			int two_steps = one_step + increment_n;
+			if (!piece.HasMoved() && two_steps >= 0 && two_steps < BITBOARD_SIDE &&
+				!(occupied & SquareBit(square + 2 * increment_n * BITBOARD_SIDE))) {
+				targets |= SquareBit(square + 2 * increment_n * BITBOARD_SIDE);
+			}
+		}
+		targets |= PawnAttacks(is_white, square) & enemies;
+		break;
+	}
+	}
+
+	if (safety.king_square >= 0) {
+		targets &= safety.check_mask;
+		if (safety.pinned & SquareBit(square)) {
+			for (int i = 0; i < safety.pin_count; ++i) {
+				if (safety.pinned_squares[i] == square) {
+					targets &= RayMask(safety.king_square, safety.pin_rays[i]);
+				}
+			}
+		}
+	}
+
+	// En passant removes two pawns from one row, so the king is looked at directly
+	if (piece.Piece() == ChessPiece::PAWN && en_passant_.first) {
+		int dest = en_passant_.second.first * BITBOARD_SIDE + en_passant_.second.second;
+		int captured = row * BITBOARD_SIDE + en_passant_.second.second;
+		if ((PawnAttacks(is_white, square) & SquareBit(dest)) && tiles_[captured].Piece() != ChessPiece::EMPTY) {
+			Bitboard occupied_after = (occupied & ~SquareBit(square) & ~SquareBit(captured)) | SquareBit(dest);
+			if (safety.king_square < 0 ||
+				!IsKingAttacked(team, safety.king_square, occupied_after, SquareBit(captured))) {
+				targets |= SquareBit(dest);
+			}
+		}
+	}
+	return targets;
+}
@@ -1,7 +1,10 @@
 #pragma once
 
 #include "chess.h"
+#include "nnue.h"
 #include "piece_value_calculator.h"
+#include "transposition_table.h"
+#include "work_stealing_pool.h"
 
 #include <tuple>
 #include <vector>
@@ -9,6 +12,11 @@
 #include <list>
 #include <deque>
 #include <stack>
+#include <chrono>
+#include <atomic>
+#include <random>
+#include <optional>
+#include <thread>
 
 struct MoveData {
 	std::pair<int, int> start;
@@ -23,15 +31,11 @@ bool operator!=(const BoardTile& first, const BoardTile& second) {
 	return false;
 }
 
+// Copies the piece list kept by the board, sorted to row-major order so the search tries moves in a stable order
 void UpdatePieces(std::vector<std::pair<int, int>>& source, const Chess& board, ChessTeam team) {
-	source.clear();
-	for (int n = 0; n < board.GetDimensions().first; ++n) {
-		for (int m = 0; m < board.GetDimensions().second; ++m) {
-			if (board.LookUp(n, m).piece_team == team) {
-				source.push_back({ n, m });
-			}
-		}
-	}
+	PieceList pieces = board.GetPieces(team);
+	source.assign(pieces.begin(), pieces.end());
+	std::sort(source.begin(), source.end());
 }
 
 // Add pawn promotion
@@ -201,161 +205,693 @@ struct FullMoveData {
 	std::pair<BoardTile, std::pair<int, int>> captured_piece;
 	std::pair<bool, std::pair<int, int>> en_passant;
 	std::pair<bool, ChessPiece> promotion_data;
+	Move move;
+	Chess::UndoInfo undo;                // Filled by the search when the move is made
+	int order_score = 0;                 // Filled by the search to pick the next move
 };
 
-// Castling reverse does not work properly if rook is initialy not at the border of the board
-void ReverseMove(Chess& board, const FullMoveData& data) {
-	BoardTile moved_piece = board.LookUp(data.own_move.end.first, data.own_move.end.second);
-	board.PutPieceInPosition({ ChessPiece::EMPTY, ChessTeam::NEUTRAL, false }, data.own_move.end.first, data.own_move.end.second);
-	moved_piece.has_moved = data.has_moved;
-	if (data.promotion_data.first) {
-		moved_piece.piece_type = ChessPiece::PAWN;
-	}
-	board.PutPieceInPosition(moved_piece, data.own_move.start.first, data.own_move.start.second);
-	board.PutPieceInPosition(data.captured_piece.first, data.captured_piece.second.first, data.captured_piece.second.second);
-	board.SetEnpassantData(data.en_passant);
-	board.SwitchTurnSequence();
-	if (moved_piece.piece_type == ChessPiece::KING &&
-		std::abs(data.own_move.start.second - data.own_move.end.second) == 2) {
-		int pos = 0;
-		if (data.own_move.start.second < data.own_move.end.second) {
-			pos = board.GetDimensions().second - 1;
-		}
-		board.PutPieceInPosition({ ChessPiece::ROOK, board.WhoseMove(), false}, data.own_move.start.first, pos);
-		board.PutPieceInPosition({ ChessPiece::EMPTY, ChessTeam::NEUTRAL, false }, data.own_move.start.first,
-								   (data.own_move.start.second + data.own_move.end.second) / 2);
+// Gain of a legal move for the side making it, negated for write_negative, with the data to show and undo it
+// The gain is told from the material the move takes alone (in PAWN_SCORE units), for ordering and pruning
+// before it is made. The search replaces it with the change of EvaluatePosition() once the move is on the board
+std::pair<int, FullMoveData> DescribeMoveOP(const Chess& board, Move move, bool write_negative) {
+	FullMoveData output;
+	int columns = board.GetDimensions().second;
+	int n_in = move.From() / columns;
+	int m_in = move.From() % columns;
+	int n_out = move.To() / columns;
+	int m_out = move.To() % columns;
+	int value_change = 0;
+	BoardTile dest_tile = board.LookUp(n_out, m_out);
+	output.own_move.start = { n_in, m_in };
+	output.own_move.end = { n_out, m_out };
+	output.captured_piece = { dest_tile, {n_out, m_out} };
+	output.has_moved = board.LookUp(n_in, m_in).has_moved;
+	output.en_passant = board.GetEnpassantData();
+	output.promotion_data = { move.IsPromotion(), move.Promotion() };
+	output.move = move;
+
+	if (move.IsEnPassant()) {
+		value_change += 1;
+		output.captured_piece = { board.LookUp(n_in, m_out), {n_in, m_out} };
+	}
+	value_change += GivePieceValue(dest_tile.piece_type);
+	if (move.IsPromotion()) {
+		value_change += GivePieceValue(move.Promotion()) - GivePieceValue(ChessPiece::PAWN);
 	}
+	value_change *= PAWN_SCORE;
+	return { write_negative ? -value_change : value_change, output };
 }
 
-uint32_t GenerateMovesOP(const Chess& board, std::vector<std::pair<int, FullMoveData>>& stack, bool write_negative) {
-	uint32_t num_moves_generated = 0;
-	FullMoveData output;
-	ChessTeam team = board.WhoseMove();
-	std::vector<std::pair<int, int>> pieces;
-	std::deque<std::pair<int, int>> moves;
-	int8_t multiplier = 1;
-	if (write_negative) {
-		multiplier = -1;
+uint32_t GenerateMovesOP(const Chess& board, std::vector<std::pair<int, FullMoveData>>& stack, bool write_negative,
+	MoveKind kind = MoveKind::ALL) {
+	MoveBuffer legal_moves;
+	board.GenerateLegalMoves(legal_moves, kind);
+	for (Move move : legal_moves) {
+		stack.push_back(DescribeMoveOP(board, move, write_negative));
 	}
-	UpdatePieces(pieces, board, team);
-	for (auto [n_in, m_in] : pieces) {
-		moves = board.GetPossibleDestTiles(n_in, m_in);
-		for (auto [n_out, m_out] : moves) {
-			int value_change = 0;
-			BoardTile dest_tile = board.LookUp(n_out, m_out);
-			output.own_move.start = { n_in, m_in };
-			output.own_move.end = { n_out, m_out };
-			output.captured_piece = { dest_tile, {n_out, m_out} };
-			output.has_moved = board.LookUp(n_in, m_in).has_moved;
-			output.en_passant = board.GetEnpassantData();
-			output.promotion_data.first = false;
-
-			if (board.LookUp(n_in, m_in).piece_type == ChessPiece::PAWN &&
-				dest_tile.piece_type == ChessPiece::EMPTY &&
-				std::abs(m_in - m_out) == 1) {
+	return uint32_t(legal_moves.size());
+}
 
-				value_change += 1;
-				output.captured_piece = { board.LookUp(n_in, m_out), {n_in, m_out} };
-			}
-			value_change += GivePieceValue(dest_tile.piece_type);
-			if (board.LookUp(n_in, m_in).piece_type == ChessPiece::PAWN &&
-				(n_out == 0 || n_out == board.GetDimensions().first - 1)) {
+// Budget of one PlayMoveTimed() call, zero means no limit. The search stops at whichever limit comes first
+struct SearchLimits {
+	std::chrono::milliseconds time{ 0 };
+	uint64_t nodes = 0;                  // Nodes of the main thread, helper threads are not counted
+	uint8_t max_depth = 64;
+	int threads = 1;                     // Main thread included, see SearchHelpers
+	const std::atomic<bool>* stop = nullptr; // Set from another thread to stop the search like a used up limit
+	bool selective = true;               // Null-move pruning, late move reductions and losing-capture pruning,
+	                                     // see SearchRootMove()
+	const NnueNetwork* network = nullptr; // Values 8x8 positions instead of EvaluatePosition() if set and loaded
+};
 
-				output.promotion_data.first = true;
+// Time to spend on one move of a game played on a clock: an even share of the remaining time plus most
+// of the increment, never closer than a small reserve to running out
+// moves_to_go = 0 means the clock has no next time control, a share of 1/30 is taken then
+SearchLimits LimitsFromClock(std::chrono::milliseconds remaining, std::chrono::milliseconds increment,
+	int moves_to_go = 0) {
+	using namespace std::chrono_literals;
+	std::chrono::milliseconds reserve = std::min<std::chrono::milliseconds>(50ms, remaining / 10);
+	std::chrono::milliseconds usable = remaining - reserve;
+	std::chrono::milliseconds share = usable / ((moves_to_go > 0) ? moves_to_go : 30) + increment * 3 / 4;
+	SearchLimits limits;
+	limits.time = std::max<std::chrono::milliseconds>(1ms, std::min(share, usable));
+	return limits;
+}
+
+// Counts searched nodes and tells a running search when its limits are used up
+class SearchControl {
+public:
+	// No limits
+	SearchControl() = default;
+
+	SearchControl(const SearchLimits& limits) : limits_(limits) {
+	}
 
-				output.promotion_data.second = ChessPiece::QUEEN;
-				value_change += 8;
-				stack.push_back({ value_change * multiplier, output });
-				value_change -= 8;
+	// Called for every move made by the search, returns 'false' once the search has to stop
+	// The clock is only read every CLOCK_CHECK_INTERVAL nodes
+	bool CountNode() {
+		++nodes_;
+		if (IsStopRequested() || (limits_.nodes > 0 && nodes_ >= limits_.nodes)) {
+			is_stopped_ = true;
+		}
+		if (limits_.time.count() > 0 && (nodes_ & (CLOCK_CHECK_INTERVAL - 1)) == 0 && Elapsed() >= limits_.time) {
+			is_stopped_ = true;
+		}
+		return !is_stopped_;
+	}
 
-				output.promotion_data.second = ChessPiece::KNIGHT;
-				value_change += 2;
-				stack.push_back({ value_change * multiplier, output });
-				value_change -= 2;
+	bool IsStopped() const {
+		return is_stopped_;
+	}
 
-				output.promotion_data.second = ChessPiece::BISHOP;
-				value_change += 2;
-				stack.push_back({ value_change * multiplier, output });
-				value_change -= 2;
+	bool IsSelective() const {
+		return limits_.selective;
+	}
 
-				output.promotion_data.second = ChessPiece::ROOK;
-				value_change += 4;
-				stack.push_back({ value_change * multiplier, output });
-				value_change -= 4;
+	// Network that values the positions of a board, nullptr if EvaluatePosition() does
+	const NnueNetwork* GetNetwork(const Chess& board) const {
+		bool is_usable = limits_.network != nullptr && limits_.network->IsLoaded() && NnueNetwork::Supports(board);
+		return is_usable ? limits_.network : nullptr;
+	}
 
-				num_moves_generated += 4;
+	uint64_t GetNodes() const {
+		return nodes_;
+	}
+
+	std::chrono::milliseconds Elapsed() const {
+		return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_);
+	}
+
+	// An iteration takes several times longer than the one before it. Once half of the time is gone,
+	// the next one would most likely be cut off and wasted
+	bool CanStartIteration() const {
+		return !is_stopped_ && !IsStopRequested() && (limits_.time.count() == 0 || Elapsed() < limits_.time / 2);
+	}
+
+private:
+	static constexpr uint64_t CLOCK_CHECK_INTERVAL = 1024;
+
+	SearchLimits limits_;
+	std::chrono::steady_clock::time_point start_ = std::chrono::steady_clock::now();
+	uint64_t nodes_ = 0;
+	bool is_stopped_ = false;
+
+	bool IsStopRequested() const {
+		return limits_.stop != nullptr && limits_.stop->load(std::memory_order_relaxed);
+	}
+};
+
+// Move ordering tables of the search: the principal variation (PV) of the last iteration, killer moves per ply
+// and a butterfly history table (by team, origin and destination tile) of quiet moves that caused cutoffs
+// Kept across iterations and between the moves of a game, Clear() them when a new game starts
+class MoveOrdering {
+public:
+	// Deeper plies than a uint8_t depth can reach never occur
+	static constexpr int MAX_PLY = 256;
+
+	MoveOrdering() : pv_table_(MAX_PLY * MAX_PLY), pv_length_(MAX_PLY, 0), killers_(MAX_PLY) {
+	}
+
+	void Clear() {
+		std::fill(history_.begin(), history_.end(), 0);
+		std::fill(killers_.begin(), killers_.end(), std::pair<Move, Move>());
+		previous_pv_.clear();
+	}
+
+	// Called before the first iteration of a search. Sizes the history table for the board, while old
+	// history is kept at half weight and killers of the previous position are dropped
+	void NewSearch(const Chess& board) {
+		std::pair<int, int> dims = board.GetDimensions();
+		int tile_count = dims.first * dims.second;
+		if (tile_count != tile_count_) {
+			tile_count_ = tile_count;
+			previous_pv_.clear();
+			history_.assign((tile_count <= MAX_HISTORY_TILES) ? 2 * size_t(tile_count) * tile_count : 0, 0);
+		}
+		for (int& entry : history_) {
+			entry /= 2;
+		}
+		std::fill(killers_.begin(), killers_.end(), std::pair<Move, Move>());
+	}
+
+	// Higher scores are searched first: PV move, captures and promotions by MVV-LVA, killers, quiet moves
+	// by history. The board is the position the move is made from
+	int Score(const Chess& board, const FullMoveData& data, int level, Move pv_move) const {
+		Move move = data.move;
+		if (move == pv_move) {
+			return PV_SCORE;
+		}
+		if (move.IsCapture() || move.IsPromotion()) {
+			int victim = GivePieceValue(data.captured_piece.first.piece_type);
+			int attacker = GivePieceValue(board.LookUp(data.own_move.start.first, data.own_move.start.second).piece_type);
+			int promotion = move.IsPromotion() ? GivePieceValue(move.Promotion()) : 0;
+			return CAPTURE_SCORE + (victim + promotion) * 16 - attacker;
+		}
+		if (move == killers_[level].first) {
+			return KILLER_SCORE + 1;
+		}
+		if (move == killers_[level].second) {
+			return KILLER_SCORE;
+		}
+		return history_.empty() ? 0 : history_[HistoryIndex(board.WhoseMove(), move)];
+	}
+
+	// A quiet move refuted the ply at 'level' with 'remaining_depth' plies searched below it
+	void AddCutoff(ChessTeam team, Move move, int level, int remaining_depth) {
+		if (move.IsCapture() || move.IsPromotion()) {
+			return;
+		}
+		if (!(killers_[level].first == move)) {
+			killers_[level].second = killers_[level].first;
+			killers_[level].first = move;
+		}
+		if (!history_.empty()) {
+			int& entry = history_[HistoryIndex(team, move)];
+			entry = std::min(entry + remaining_depth * remaining_depth, MAX_HISTORY);
+		}
+	}
+
+	// Triangular PV table: the line starting at each level is built from the line of the level below it
+	void StartPvLine(int level) {
+		pv_length_[level] = level;
+	}
+
+	void UpdatePvLine(int level, Move move) {
+		Move* line = &pv_table_[size_t(level) * MAX_PLY];
+		const Move* child_line = &pv_table_[size_t(level + 1) * MAX_PLY];
+		line[level] = move;
+		int length = std::max(level + 1, pv_length_[level + 1]);
+		for (int i = level + 1; i < length; ++i) {
+			line[i] = child_line[i];
+		}
+		pv_length_[level] = length;
+	}
+
+	// The root move with the line found below it becomes the PV searched first by the next iteration
+	void StoreRootLine(Move root_move) {
+		previous_pv_.assign(1, root_move);
+		const Move* line = &pv_table_[MAX_PLY];
+		for (int i = 1; i < pv_length_[1]; ++i) {
+			previous_pv_.push_back(line[i]);
+		}
+	}
+
+	// Move of the previous PV at a level, an empty Move if the PV is shorter
+	Move PvMove(int level) const {
+		return (level < int(previous_pv_.size())) ? previous_pv_[level] : Move();
+	}
+
+	// Quiet moves that refuted other plies of a level, newest first. Empty Moves if there are none
+	std::pair<Move, Move> Killers(int level) const {
+		return killers_[level];
+	}
+
+private:
+	static constexpr int PV_SCORE = 1 << 30;
+	static constexpr int CAPTURE_SCORE = 1 << 28;
+	static constexpr int KILLER_SCORE = 1 << 27;
+	static constexpr int MAX_HISTORY = (1 << 26) - 1;
+	// Larger boards would need a table of several megabytes, quiet moves keep generation order there
+	static constexpr int MAX_HISTORY_TILES = 1024;
+
+	int tile_count_ = 0;
+	std::vector<Move> pv_table_;
+	std::vector<int> pv_length_;
+	std::vector<Move> previous_pv_;
+	std::vector<std::pair<Move, Move>> killers_;
+	std::vector<int> history_;
+
+	size_t HistoryIndex(ChessTeam team, Move move) const {
+		return ((team == ChessTeam::WHITE) ? 0 : size_t(tile_count_) * tile_count_) +
+			size_t(move.From()) * tile_count_ + move.To();
+	}
+};
+
+// Hands out the moves of one ply in stages: PV move, captures and promotions by MVV-LVA, killer moves,
+// quiet moves by history. A group is generated only once the search gets to it, so a ply that is cut off
+// early never generates or stores its quiet moves
+// Moves are appended to moves_data, which has to end with the moves of this ply whenever Next() is called
+class MovePicker {
+public:
+	MovePicker() = default;
+
+	// pv_move is tried first if it is legal, an empty Move skips that stage
+	// With captures_only the picker stops after captures and promotions, as a quiescence search needs
+	MovePicker(Move pv_move, int level, bool write_negative, bool captures_only = false) :
+		stage_(captures_only ? Stage::GENERATE_CAPTURES : Stage::PV_MOVE), pv_move_(pv_move), level_(level),
+		write_negative_(write_negative), captures_only_(captures_only) {
+	}
+
+	// Gives the index of the next move in moves_data, returns 'false' once all moves were handed out
+	bool Next(const Chess& board, std::vector<std::pair<int, FullMoveData>>& moves_data, const MoveOrdering& ordering,
+		size_t& index) {
+		while (true) {
+			switch (stage_) {
+			case Stage::PV_MOVE:
+				stage_ = Stage::GENERATE_CAPTURES;
+				if (!(pv_move_ == Move()) && board.IsMoveLegal(pv_move_)) {
+					return Hand(DescribeMoveOP(board, pv_move_, write_negative_), moves_data, index);
+				}
+				break;
+			case Stage::GENERATE_CAPTURES:
+				Generate(board, moves_data, ordering, MoveKind::CAPTURES);
+				stage_ = Stage::CAPTURES;
+				break;
+			case Stage::CAPTURES:
+			case Stage::QUIETS:
+				if (next_ < moves_data.size()) {
+					index = PickBest(moves_data);
+					return true;
+				}
+				stage_ = (stage_ == Stage::CAPTURES && !captures_only_) ? Stage::KILLERS : Stage::DONE;
+				break;
+			case Stage::KILLERS:
+			{
+				std::pair<Move, Move> killers = ordering.Killers(level_);
+				Move killer = (killer_count_ == 0) ? killers.first : killers.second;
+				if (killer_count_ == 2) {
+					stage_ = Stage::GENERATE_QUIETS;
+					break;
+				}
+				++killer_count_;
+				if (!(killer == Move()) && !(killer == pv_move_) && board.IsMoveLegal(killer)) {
+					played_killers_[killer_count_ - 1] = killer;
+					return Hand(DescribeMoveOP(board, killer, write_negative_), moves_data, index);
+				}
+				break;
 			}
-			else {
-				++num_moves_generated;
-				stack.push_back({ value_change * multiplier, output });
+			case Stage::GENERATE_QUIETS:
+				Generate(board, moves_data, ordering, MoveKind::QUIETS);
+				stage_ = Stage::QUIETS;
+				break;
+			case Stage::DONE:
+				return false;
 			}
 		}
 	}
-	return num_moves_generated;
+
+private:
+	enum class Stage : uint8_t {
+		PV_MOVE,
+		GENERATE_CAPTURES,
+		CAPTURES,
+		KILLERS,
+		GENERATE_QUIETS,
+		QUIETS,
+		DONE
+	};
+
+	Stage stage_ = Stage::PV_MOVE;
+	Move pv_move_;
+	Move played_killers_[2];
+	int killer_count_ = 0;
+	int level_ = 0;
+	bool write_negative_ = false;
+	bool captures_only_ = false;
+	size_t next_ = 0;                    // First move of moves_data not handed out yet
+
+	bool Hand(std::pair<int, FullMoveData>&& move, std::vector<std::pair<int, FullMoveData>>& moves_data,
+		size_t& index) {
+		moves_data.push_back(std::move(move));
+		index = moves_data.size() - 1;
+		next_ = moves_data.size();
+		return true;
+	}
+
+	// Appends a group of moves with their scores, leaving out those handed out by earlier stages
+	void Generate(const Chess& board, std::vector<std::pair<int, FullMoveData>>& moves_data,
+		const MoveOrdering& ordering, MoveKind kind) {
+		next_ = moves_data.size();
+		GenerateMovesOP(board, moves_data, write_negative_, kind);
+		for (size_t i = next_; i < moves_data.size(); ) {
+			Move move = moves_data[i].second.move;
+			if (move == pv_move_ || move == played_killers_[0] || move == played_killers_[1]) {
+				moves_data[i] = std::move(moves_data.back());
+				moves_data.pop_back();
+				continue;
+			}
+			moves_data[i].second.order_score = ordering.Score(board, moves_data[i].second, level_, Move());
+			++i;
+		}
+	}
+
+	// Selection instead of a full sort, a ply that is cut off early never orders the rest of its moves
+	size_t PickBest(std::vector<std::pair<int, FullMoveData>>& moves_data) {
+		size_t best = next_;
+		for (size_t i = next_ + 1; i < moves_data.size(); ++i) {
+			if (moves_data[i].second.order_score > moves_data[best].second.order_score) {
+				best = i;
+			}
+		}
+		if (best != next_) {
+			std::swap(moves_data[best], moves_data[next_]);
+		}
+		return next_++;
+	}
+};
+
+// One ply of the alpha-beta search in PlayMoveOP, its moves sit in moves_data from first_move on
+struct SearchPly {
+	MovePicker picker;
+	size_t first_move = 0;
+	size_t current_move = 0;             // Move searched right now, or the last one
+	bool has_moves = false;              // At least one move was handed out
+	int alpha = 0;
+	int beta = 0;
+	int value = 0;                       // Best so far, starts at the value of a ply without moves
+	int eval = 0;                        // Static value of the position for 'team', gains of its moves count from it
+	bool is_own = false;                 // Own plies take the maximum, enemy plies the minimum
+	bool on_pv = false;                  // Reached by following the PV of the previous iteration
+	bool is_quiescence = false;          // Past the nominal depth, only captures and promotions are searched
+	bool is_stored = false;              // Value taken from the transposition table, no moves are searched
+	int alpha_start = 0;                 // Window the ply was entered with, tells the bound of its value
+	int beta_start = 0;
+	Move best_move;                      // Move that gave the value so far
+	int depth_left = 0;                  // Full-width plies left, this one included. Quiescence from 0 on
+	int reduction = 0;                   // Plies taken off by a late move reduction, 0 for a full-depth search
+	int moves_searched = 0;
+	bool is_in_check = false;
+	bool can_pass = false;               // Null move still to be tried before the moves
+	bool is_passing = false;             // Its child is reached by a null move
+	bool after_pass = false;             // Reached by a null move, no second one in a row
+	Chess::UndoInfo pass_undo;
+};
+
+// Wider than any value the search can give, shifted windows stay far from overflowing
+constexpr int SEARCH_INFINITY = INT32_MAX / 4 * 3;
+
+// Delta pruning: a capture in the quiescence search is skipped if even its gain plus this margin
+// leaves the side to move no better than it already is
+constexpr int DELTA_MARGIN = 2 * PAWN_SCORE;
+
+// Losing captures: a capture or promotion the static exchange on its tile says loses material is skipped by
+// the quiescence search, and by selective full-width plies this close to the depth once another move is searched
+constexpr int SEE_PRUNE_DEPTH = 2;
+
+// Null-move pruning: a side that stays at or above beta even after passing its turn is cut off without
+// searching its moves. The null move is searched NULL_MOVE_REDUCTION plies shallower
+constexpr int NULL_MOVE_REDUCTION = 2;
+constexpr int NULL_MOVE_MIN_DEPTH = 3;
+
+// Late move reductions: quiet moves after the first LMR_FULL_MOVES of a ply are searched one ply shallower
+// with a null window, and again at full depth only if they beat the bound
+constexpr int LMR_FULL_MOVES = 3;
+constexpr int LMR_MIN_DEPTH = 3;
+
+// Upper and lower bounds trade places when a value is seen from the other side
+TableBound FlipBound(TableBound bound) {
+	if (bound == TableBound::UPPER) {
+		return TableBound::LOWER;
+	}
+	return (bound == TableBound::LOWER) ? TableBound::UPPER : bound;
 }
 
-// Add promotion data output
-FullMoveData PlayMoveOP(Chess board, ChessTeam team, uint8_t depth) {
-	std::vector<std::pair<int, FullMoveData>> moves_data;
-	moves_data.reserve(uint32_t(depth) * 50);
-	std::vector<std::pair<int, FullMoveData>> first_moves;
-	GenerateMovesOP(board, first_moves, false);
+// Value of a root move searched to the given depth, cut off outside of (alpha, beta)
+// Full-width plies look up and store their positions in the table, if one is given. A stored value searched
+// at least as deep ends the ply when its bound allows, otherwise its move is searched first
+// A selective control (see SearchLimits) adds null-move pruning, skipped in check, on the PV and for a side
+// with only pawns and kings, late move reductions of quiet moves that don't give check and pruning of losing
+// captures near the depth (SEE_PRUNE_DEPTH)
+// Past the depth a quiescence search follows captures and promotions until the position is quiet. Its plies
+// start from the stand-pat value, the side to move may always decline to capture. Captures and promotions that
+// lose material by Chess::StaticExchange() are not searched
+// Inside the window the value is exact, outside of it the returned value is a bound on the exact one
+// If the control stops the search, the board is restored and the returned value is meaningless
+int SearchRootMove(Chess& board, ChessTeam team, uint8_t depth, const std::pair<int, FullMoveData>& root_move,
+	std::vector<std::pair<int, FullMoveData>>& moves_data, int alpha, int beta, SearchControl& control,
+	MoveOrdering& ordering, TranspositionTable* table = nullptr) {
+	control.CountNode();
+	// A network follows the board through an accumulator for the whole search of the root move
+	std::optional<NnueAccumulator> accumulator;
+	if (const NnueNetwork* network = control.GetNetwork(board)) {
+		accumulator.emplace(*network, board);
+	}
+	auto evaluate = [&]() {
+		return accumulator ? accumulator->Evaluate(team) : EvaluatePosition(board, team);
+	};
+	int root_eval = evaluate();
+	Chess::UndoInfo root_undo = board.MakeMove(root_move.second.move);
+	int root_gain = evaluate() - root_eval;
+	std::vector<SearchPly> plies;
+	plies.reserve(depth);
+	// Ply values carry the gains of moves made above them, windows are shifted by these gains on the way down
+	// A gain is the change of the static value a move makes: EvaluatePosition(), read from state the board keeps
+	// and the pawn table, or the network of the control, read from its accumulator. No node scans the board
+	// Plies are numbered by their level: the root moves are level 0
+	auto push_ply = [&](int ply_alpha, int ply_beta, bool on_pv, int depth_left, int reduction, bool after_pass) {
+		SearchPly ply;
+		int level = int(plies.size()) + 1;
+		ply.depth_left = depth_left;
+		ply.reduction = reduction;
+		ply.after_pass = after_pass;
+		ply.is_quiescence = (depth_left <= 0);
+		ply.first_move = moves_data.size();
+		ply.alpha = ply_alpha;
+		ply.beta = ply_beta;
+		ply.alpha_start = ply_alpha;
+		ply.beta_start = ply_beta;
+		ply.is_own = (level % 2 == 0);
+		ply.on_pv = on_pv;
+		ply.eval = evaluate();
+		// Gains above the ply are already counted, so standing pat is worth 0
+		ply.value = ply.is_quiescence ? 0 : Refresh_Values(uint8_t(level));
+		// A PV move kept from an earlier search may be quiet, quiescence plies take no PV move
+		Move first_move = (on_pv && !ply.is_quiescence) ? ordering.PvMove(level) : Move();
+		TableEntry entry;
+		if (table != nullptr && !ply.is_quiescence && table->Probe(board.GetZobristKey(), entry)) {
+			if (first_move == Move()) {
+				first_move = entry.move;
+			}
+			// Table scores are counted from the side to move, ply values from the side of 'team'
+			int score = ply.is_own ? entry.score : -entry.score;
+			TableBound bound = ply.is_own ? entry.bound : FlipBound(entry.bound);
+			if (entry.depth >= depth_left && (bound == TableBound::EXACT ||
+				(bound == TableBound::LOWER && score >= ply_beta) || (bound == TableBound::UPPER && score <= ply_alpha))) {
+				ply.value = score;
+				ply.is_stored = true;
+			}
+		}
+		if (!ply.is_quiescence && !ply.is_stored && control.IsSelective()) {
+			ply.is_in_check = board.IsInCheck();
+			// Standing pat (0) must already reach the bound for passing to have a chance of a cutoff
+			ply.can_pass = !on_pv && !after_pass && !ply.is_in_check && depth_left >= NULL_MOVE_MIN_DEPTH &&
+				(ply.is_own ? 0 >= ply_beta : 0 <= ply_alpha) && board.HasPiecesBeyondPawns(board.WhoseMove());
+		}
+		ply.picker = MovePicker(first_move, level, board.WhoseMove() != team, ply.is_quiescence);
+		if (level < MoveOrdering::MAX_PLY) {
+			ordering.StartPvLine(level);
+		}
+		plies.push_back(ply);
+	};
+	// Returns 'true' if the value is the best so far and lies inside the window
+	auto add_value = [](SearchPly& ply, int value) {
+		if (ply.is_own) {
+			bool is_better = value > ply.value && value > ply.alpha;
+			ply.value = std::max(ply.value, value);
+			ply.alpha = std::max(ply.alpha, ply.value);
+			return is_better;
+		}
+		bool is_better = value < ply.value && value < ply.beta;
+		ply.value = std::min(ply.value, value);
+		ply.beta = std::min(ply.beta, ply.value);
+		return is_better;
+	};
 
-	if (depth > 1) {
-
-		std::vector<int> depth_values(depth, 0);
-		for (uint8_t i = 1; i < depth_values.size(); ++i) {
-			depth_values[i] = Refresh_Values(i);
-		}
-		std::vector<int> rem_depth(depth, 0);
-		FullMoveData tmp;
-
-		for (auto& first_move : first_moves) {
-			moves_data.push_back(first_move);
-			depth_values[0] = INT32_MIN / 2;
-			rem_depth[0] = 1;
-			uint8_t cur_depth = 0;
-			while (rem_depth[0] > 0) {
-				if (cur_depth < depth - 1 && rem_depth[cur_depth] != 0) {
-					++cur_depth;
-					tmp = moves_data.back().second;
-					board.ForceMove(tmp.own_move.start, tmp.own_move.end);
-					if (tmp.promotion_data.first) {
-						board.PawnPromotion(tmp.promotion_data.second);
-					}
-					rem_depth[cur_depth] = GenerateMovesOP(board, moves_data, board.WhoseMove() != team);
-				}
-				else {
-					if (cur_depth == depth - 1) {
-						while (rem_depth[cur_depth] != 0) {
-							if (cur_depth % 2 == 0) {
-								depth_values[cur_depth] = std::max(depth_values[cur_depth], moves_data.back().first);
-							}
-							else {
-								depth_values[cur_depth] = std::min(depth_values[cur_depth], moves_data.back().first);
-							}
-							--rem_depth[cur_depth];
-							moves_data.pop_back();
-						}
-					}
-					--cur_depth;
-					int val_tmp = moves_data.back().first + depth_values[cur_depth + 1];
-					if (cur_depth % 2 == 0) {
-						depth_values[cur_depth] = std::max(val_tmp, depth_values[cur_depth]);
-					}
-					else {
-						depth_values[cur_depth] = std::min(val_tmp, depth_values[cur_depth]);
-					}
-					depth_values[cur_depth + 1] = Refresh_Values(cur_depth + 1);
-					--rem_depth[cur_depth];
-					ReverseMove(board, moves_data.back().second);
-					moves_data.pop_back();
+	push_ply(alpha - root_gain, beta - root_gain, root_move.second.move == ordering.PvMove(0), depth - 1, 0,
+		false);
+	int result = 0;
+	while (!control.IsStopped()) {
+		SearchPly& ply = plies.back();
+		int level = int(plies.size());
+		// The null move is searched with a null window at the bound it has to keep
+		if (ply.can_pass) {
+			ply.can_pass = false;
+			ply.is_passing = true;
+			control.CountNode();
+			ply.pass_undo = board.MakeNullMove();
+			int bound = ply.is_own ? ply.beta : ply.alpha;
+			push_ply(ply.is_own ? bound - 1 : bound, ply.is_own ? bound : bound + 1, false,
+				ply.depth_left - 1 - NULL_MOVE_REDUCTION, 0, true);
+			continue;
+		}
+		bool is_cut = ply.is_own ? ply.value >= ply.beta : ply.value <= ply.alpha;
+		if (is_cut && ply.has_moves && !ply.is_quiescence) {
+			ordering.AddCutoff(board.WhoseMove(), moves_data[ply.current_move].second.move, level, ply.depth_left);
+		}
+		// Tables of the search end at MAX_PLY, a quiescence search that long stands pat
+		bool is_done = ply.is_stored || is_cut || (ply.is_quiescence && level + 1 >= MoveOrdering::MAX_PLY) ||
+			!ply.picker.Next(board, moves_data, ordering, ply.current_move);
+		if (is_done) {
+			int ply_value = ply.value;
+			int reduction = ply.reduction;
+			if (table != nullptr && !ply.is_quiescence && !ply.is_stored) {
+				TableBound bound = (ply_value <= ply.alpha_start) ? TableBound::UPPER :
+					(ply_value >= ply.beta_start) ? TableBound::LOWER : TableBound::EXACT;
+				table->Store(board.GetZobristKey(), ply.depth_left, ply.is_own ? bound : FlipBound(bound),
+					ply.is_own ? ply_value : -ply_value, ply.best_move);
+			}
+			moves_data.resize(ply.first_move);
+			plies.pop_back();
+			if (plies.empty()) {
+				result = ply_value;
+				break;
+			}
+			SearchPly& parent = plies.back();
+			if (parent.is_passing) {
+				// The bound itself is taken as the value, a side left without moves after passing proves nothing
+				parent.is_passing = false;
+				board.UnmakeNullMove(parent.pass_undo);
+				if (parent.is_own ? ply_value >= parent.beta : ply_value <= parent.alpha) {
+					parent.value = parent.is_own ? parent.beta : parent.alpha;
 				}
+				continue;
 			}
-			first_move.first = depth_values[0];
+			const std::pair<int, FullMoveData>& made = moves_data[parent.current_move];
+			int value = made.first + ply_value;
+			// A reduced move that beats the bound is searched again at full depth and with the full window
+			if (reduction > 0 && (parent.is_own ? value > parent.alpha : value < parent.beta)) {
+				push_ply(parent.alpha - made.first, parent.beta - made.first, false, parent.depth_left - 1, 0, false);
+				continue;
+			}
+			board.UnmakeMove(made.second.move, made.second.undo);
+			int parent_value = parent.value;
+			if (add_value(parent, value) && !parent.is_quiescence) {
+				ordering.UpdatePvLine(level - 1, made.second.move);
+			}
+			if (parent.value != parent_value) {
+				parent.best_move = made.second.move;
+			}
+			continue;
+		}
+		std::pair<int, FullMoveData>& move = moves_data[ply.current_move];
+		if (ply.is_quiescence && (ply.is_own ? move.first + DELTA_MARGIN <= ply.alpha :
+			move.first - DELTA_MARGIN >= ply.beta)) {
+			continue;
+		}
+		if ((ply.is_quiescence || (control.IsSelective() && !ply.on_pv && !ply.is_in_check && ply.has_moves &&
+			ply.depth_left <= SEE_PRUNE_DEPTH && move.second.move.IsCapture())) &&
+			board.StaticExchange(move.second.move) < 0) {
+			continue;
+		}
+		ply.has_moves = true;
+		++ply.moves_searched;
+		control.CountNode();
+		move.second.undo = board.MakeMove(move.second.move);
+		move.first = evaluate() - ply.eval;
+		bool is_child_on_pv = ply.on_pv && move.second.move == ordering.PvMove(level);
+		Move made_move = move.second.move;
+		bool is_late_quiet = control.IsSelective() && !ply.is_quiescence && !ply.on_pv && !ply.is_in_check &&
+			ply.depth_left >= LMR_MIN_DEPTH && ply.moves_searched > LMR_FULL_MOVES && !made_move.IsCapture() &&
+			!made_move.IsPromotion() && !board.IsInCheck();
+		if (is_late_quiet) {
+			// Null window at the bound the move has to beat
+			int bound = (ply.is_own ? ply.alpha : ply.beta) - move.first;
+			push_ply(ply.is_own ? bound : bound - 1, ply.is_own ? bound + 1 : bound, false, ply.depth_left - 2, 1,
+				false);
+			continue;
+		}
+		push_ply(ply.alpha - move.first, ply.beta - move.first, is_child_on_pv, ply.depth_left - 1, 0, false);
+	}
+	// A stopped search takes back the moves still made on its way down
+	while (plies.size() > 1) {
+		plies.pop_back();
+		SearchPly& parent = plies.back();
+		if (parent.is_passing) {
+			board.UnmakeNullMove(parent.pass_undo);
+			continue;
 		}
+		const std::pair<int, FullMoveData>& made = moves_data[parent.current_move];
+		board.UnmakeMove(made.second.move, made.second.undo);
+	}
+	if (!plies.empty()) {
+		moves_data.resize(plies.front().first_move);
 	}
+	board.UnmakeMove(root_move.second.move, root_undo);
+	return std::max(INT32_MIN / 2, root_gain + result);
+}
 
+// Gives every root move its value at the given depth, returns 'false' if the control stopped the search
+// before all of them were searched. Depth 0 only counts the gain of the root move itself
+// The PV move of the previous iteration is searched first, values stay in the order of first_moves
+bool SearchRootMoves(Chess& board, ChessTeam team, uint8_t depth, std::vector<std::pair<int, FullMoveData>>& first_moves,
+	SearchControl& control, MoveOrdering& ordering, TranspositionTable* table = nullptr) {
+	if (depth == 0) {
+		return true;
+	}
+	std::vector<std::pair<int, FullMoveData>> moves_data;
+	moves_data.reserve(uint32_t(depth) * 50);
+	std::vector<size_t> search_order;
+	for (size_t i = 0; i < first_moves.size(); ++i) {
+		if (first_moves[i].second.move == ordering.PvMove(0)) {
+			search_order.insert(search_order.begin(), i);
+		}
+		else {
+			search_order.push_back(i);
+		}
+	}
+	// Root moves are searched with alpha just below the best value, so every move that ties with the best
+	// gets its exact value and the choice between equal moves in ChooseRootMove() stays the same as
+	// a full-width search
+	int best_root_value = INT32_MIN / 2;
+	Move best_root_move;
+	for (size_t i : search_order) {
+		std::pair<int, FullMoveData>& first_move = first_moves[i];
+		first_move.first = SearchRootMove(board, team, depth, first_move, moves_data, best_root_value - 1,
+			SEARCH_INFINITY, control, ordering, table);
+		if (control.IsStopped()) {
+			return false;
+		}
+		if (first_move.first > best_root_value || best_root_move == Move()) {
+			best_root_value = std::max(best_root_value, first_move.first);
+			best_root_move = first_move.second.move;
+			ordering.StoreRootLine(best_root_move);
+		}
+	}
+	return true;
+}
+
+// The move of highest value. Among equal ones the first pawn move is preferred, otherwise the last one
+FullMoveData ChooseRootMove(const Chess& board, const std::vector<std::pair<int, FullMoveData>>& first_moves) {
 	int best_value = INT32_MIN;
 	for (const std::pair<int, FullMoveData>& move : first_moves) {
 		if (best_value < move.first) {
@@ -374,4 +910,259 @@ FullMoveData PlayMoveOP(Chess board, ChessTeam team, uint8_t depth) {
 		}
 	}
 	return output;
-}
\ No newline at end of file
+}
+
+// Helper threads of a Lazy SMP search. Each helper deepens the same root on its own copy of the board and
+// shares nothing with the main thread but the transposition table, which it fills with entries the main thread
+// then finds. Helpers start at alternating depths and take the root moves in their own shuffled order, so they
+// spread over different parts of the tree. Their results are never played
+// Helpers run until max_depth or until the object is destroyed, which stops and joins them
+// They value positions as the main thread does, with the same network if it has one, and prune as selectively,
+// so table entries agree
+class SearchHelpers {
+public:
+	SearchHelpers(const Chess& board, ChessTeam team, const std::vector<std::pair<int, FullMoveData>>& first_moves,
+		uint8_t max_depth, int count, TranspositionTable& table, const NnueNetwork* network = nullptr,
+		bool selective = true) {
+		for (int index = 1; index <= count; ++index) {
+			threads_.emplace_back(&SearchHelpers::Run, this, board, team, first_moves, max_depth, index, std::ref(table),
+				network, selective);
+		}
+	}
+
+	SearchHelpers(const SearchHelpers&) = delete;
+
+	SearchHelpers& operator=(const SearchHelpers&) = delete;
+
+	~SearchHelpers() {
+		stop_.store(true, std::memory_order_relaxed);
+		for (std::thread& thread : threads_) {
+			thread.join();
+		}
+	}
+
+private:
+	std::atomic<bool> stop_{ false };
+	std::vector<std::thread> threads_;
+
+	// Board and root moves are copies owned by the thread
+	void Run(Chess board, ChessTeam team, std::vector<std::pair<int, FullMoveData>> first_moves, uint8_t max_depth,
+		int index, TranspositionTable& table, const NnueNetwork* network, bool selective) {
+		SearchLimits limits;
+		limits.stop = &stop_;
+		limits.network = network;
+		limits.selective = selective;
+		SearchControl control(limits);
+		MoveOrdering ordering;
+		ordering.NewSearch(board);
+		std::mt19937 random(index);
+		std::shuffle(first_moves.begin(), first_moves.end(), random);
+		std::vector<std::pair<int, FullMoveData>> iteration_moves;
+		for (int depth = 1 + index % 2; depth <= max_depth && control.CanStartIteration(); ++depth) {
+			iteration_moves = first_moves;
+			SearchRootMoves(board, team, uint8_t(depth), iteration_moves, control, ordering, &table);
+		}
+	}
+};
+
+// Alpha-beta search over an explicit stack of plies. Values are counted from the side of 'team':
+// own plies maximize, enemy plies minimize the static value reached along the line
+// Move ordering tables and the transposition table of a game are passed to keep them between moves,
+// see MoveOrdering and TranspositionTable. Values taken from the table may come from deeper searches
+// With threads > 1 helper threads search alongside through the same table, see SearchHelpers
+// A loaded network (see nnue.h) values 8x8 positions instead of EvaluatePosition(). Keep to one way of valuing
+// positions for all searches sharing a table
+// Without selective pruning (see SearchLimits) the move is the one a full-width search of equal depth picks
+FullMoveData PlayMoveOP(Chess board, ChessTeam team, uint8_t depth, MoveOrdering& ordering, TranspositionTable& table,
+	int threads = 1, const NnueNetwork* network = nullptr, bool selective = true) {
+	std::vector<std::pair<int, FullMoveData>> first_moves;
+	GenerateMovesOP(board, first_moves, false);
+	SearchLimits limits;
+	limits.network = network;
+	limits.selective = selective;
+	SearchControl control(limits);
+	ordering.NewSearch(board);
+	table.NewSearch();
+	SearchHelpers helpers(board, team, first_moves, depth, threads - 1, table, network, selective);
+	SearchRootMoves(board, team, depth, first_moves, control, ordering, &table);
+	return ChooseRootMove(board, first_moves);
+}
+
+FullMoveData PlayMoveOP(Chess board, ChessTeam team, uint8_t depth, MoveOrdering& ordering) {
+	TranspositionTable table;
+	return PlayMoveOP(std::move(board), team, depth, ordering, table);
+}
+
+FullMoveData PlayMoveOP(Chess board, ChessTeam team, uint8_t depth) {
+	MoveOrdering ordering;
+	return PlayMoveOP(std::move(board), team, depth, ordering);
+}
+
+// Iterative deepening within a budget: searches depth 1, 2, 3... until a limit is reached and returns
+// the move of the last iteration that was completed, the same move PlayMoveOP() gives at that depth
+// An iteration cut off by a limit is thrown away. If even depth 1 is, the move of highest gain is played
+// With limits.threads > 1 helper threads search alongside until the main thread is done, see SearchHelpers
+FullMoveData PlayMoveTimed(Chess board, ChessTeam team, const SearchLimits& limits, MoveOrdering& ordering,
+	TranspositionTable& table) {
+	std::vector<std::pair<int, FullMoveData>> first_moves;
+	GenerateMovesOP(board, first_moves, false);
+	if (first_moves.size() <= 1) {
+		return first_moves.empty() ? FullMoveData() : first_moves.front().second;
+	}
+	SearchControl control(limits);
+	ordering.NewSearch(board);
+	table.NewSearch();
+	SearchHelpers helpers(board, team, first_moves, limits.max_depth, limits.threads - 1, table, limits.network,
+		limits.selective);
+	FullMoveData best_move = ChooseRootMove(board, first_moves);
+	std::vector<std::pair<int, FullMoveData>> iteration_moves;
+	for (int depth = 1; depth <= limits.max_depth && control.CanStartIteration(); ++depth) {
+		iteration_moves = first_moves;
+		if (!SearchRootMoves(board, team, uint8_t(depth), iteration_moves, control, ordering, &table)) {
+			break;
+		}
+		best_move = ChooseRootMove(board, iteration_moves);
+	}
+	return best_move;
+}
+
+FullMoveData PlayMoveTimed(Chess board, ChessTeam team, const SearchLimits& limits, MoveOrdering& ordering) {
+	TranspositionTable table;
+	return PlayMoveTimed(std::move(board), team, limits, ordering, table);
+}
+
+FullMoveData PlayMoveTimed(Chess board, ChessTeam team, const SearchLimits& limits) {
+	MoveOrdering ordering;
+	return PlayMoveTimed(std::move(board), team, limits, ordering);
+}
+
+// Scratch state of one pool worker in PlayMoveSplit(): a board copy it makes and unmakes moves on, the move
+// stack of its search and its ordering tables
+struct SplitWorker {
+	Chess board;
+	std::vector<std::pair<int, FullMoveData>> moves_data;
+	MoveOrdering ordering;
+};
+
+// Fixed-depth search split into tasks on a work-stealing pool, meant for batch analysis. The pool is kept
+// between calls
+// Young brothers wait at the root: the root move of highest gain is searched first, then all others in parallel
+// with alpha just below its value. With split_replies the replies to each root move become tasks as well,
+// the first reply alone, then the others bounded by its value
+// Tasks share no state and start with cleared ordering tables, so the nodes of every task are the same on
+// each run whatever thread takes it. Without selective pruning (see SearchLimits) the move is the one
+// a full-width search of equal depth picks, with it the windows of the tasks may change it in rare cases
+FullMoveData PlayMoveSplit(const Chess& board, ChessTeam team, uint8_t depth, WorkStealingPool& pool,
+	bool split_replies = false, bool selective = true) {
+	std::vector<std::pair<int, FullMoveData>> first_moves;
+	GenerateMovesOP(board, first_moves, false);
+	if (depth == 0 || first_moves.empty()) {
+		return ChooseRootMove(board, first_moves);
+	}
+	std::vector<SplitWorker> workers;
+	workers.reserve(pool.GetThreadCount());
+	for (int i = 0; i < pool.GetThreadCount(); ++i) {
+		workers.push_back({ board, {}, {} });
+	}
+	auto start_task = [&](int worker) -> SplitWorker& {
+		SplitWorker& scratch = workers[worker];
+		scratch.ordering.Clear();
+		scratch.ordering.NewSearch(scratch.board);
+		return scratch;
+	};
+	split_replies = split_replies && depth >= 2;
+	// Replies are searched as root moves of the enemy one ply shallower, their values count from its side
+	ChessTeam enemy = (team == ChessTeam::WHITE) ? ChessTeam::BLACK : ChessTeam::WHITE;
+	std::vector<std::vector<std::pair<int, FullMoveData>>> replies(first_moves.size());
+	std::vector<std::vector<int>> reply_values(first_moves.size());
+	int root_alpha = -SEARCH_INFINITY;
+	SearchLimits limits;
+	limits.selective = selective;
+
+	// Searches the root moves at the given indices with alpha = root_alpha
+	auto search_root_moves = [&](const std::vector<size_t>& indices) {
+		std::vector<WorkStealingPool::Task> tasks;
+		if (!split_replies) {
+			for (size_t i : indices) {
+				tasks.push_back([&, i](int worker) {
+					SplitWorker& scratch = start_task(worker);
+					SearchControl control(limits);
+					first_moves[i].first = SearchRootMove(scratch.board, team, depth, first_moves[i], scratch.moves_data,
+						root_alpha, SEARCH_INFINITY, control, scratch.ordering);
+				});
+			}
+			pool.Run(std::move(tasks));
+			return;
+		}
+		// The enemy refutes a root move once a reply reaches beta, then its root value is at most root_alpha
+		auto enemy_beta = [&](size_t i) {
+			return first_moves[i].first - root_alpha;
+		};
+		auto search_reply = [&](size_t i, size_t j, int worker) {
+			SplitWorker& scratch = start_task(worker);
+			int root_eval = EvaluatePosition(scratch.board, team);
+			Chess::UndoInfo root_undo = scratch.board.MakeMove(first_moves[i].second.move);
+			if (j == 0) {
+				// The root move's gain becomes the change of EvaluatePosition(), as in SearchRootMove()
+				first_moves[i].first = EvaluatePosition(scratch.board, team) - root_eval;
+				// The reply of highest gain goes first, it bounds the others best
+				GenerateMovesOP(scratch.board, replies[i], false);
+				auto eldest_reply = std::max_element(replies[i].begin(), replies[i].end(),
+					[](const auto& first, const auto& second) { return first.first < second.first; });
+				if (eldest_reply != replies[i].end()) {
+					std::iter_swap(replies[i].begin(), eldest_reply);
+				}
+				reply_values[i].assign(replies[i].size(), -SEARCH_INFINITY);
+			}
+			if (j < replies[i].size()) {
+				SearchControl control(limits);
+				int alpha = (j == 0) ? -SEARCH_INFINITY : reply_values[i][0];
+				reply_values[i][j] = SearchRootMove(scratch.board, enemy, uint8_t(depth - 1), replies[i][j],
+					scratch.moves_data, alpha, enemy_beta(i), control, scratch.ordering);
+			}
+			scratch.board.UnmakeMove(first_moves[i].second.move, root_undo);
+		};
+		for (size_t i : indices) {
+			tasks.push_back([&, i](int worker) {
+				search_reply(i, 0, worker);
+			});
+		}
+		pool.Run(std::move(tasks));
+		tasks.clear();
+		for (size_t i : indices) {
+			if (!replies[i].empty() && reply_values[i][0] >= enemy_beta(i)) {
+				continue;
+			}
+			for (size_t j = 1; j < replies[i].size(); ++j) {
+				tasks.push_back([&, i, j](int worker) {
+					search_reply(i, j, worker);
+				});
+			}
+		}
+		pool.Run(std::move(tasks));
+		for (size_t i : indices) {
+			// Without replies the value is that of an enemy ply without moves, as in SearchRootMove()
+			int enemy_best = replies[i].empty() ? -Refresh_Values(1) :
+				*std::max_element(reply_values[i].begin(), reply_values[i].end());
+			first_moves[i].first = std::max(INT32_MIN / 2, first_moves[i].first - enemy_best);
+		}
+	};
+
+	size_t eldest = 0;
+	for (size_t i = 1; i < first_moves.size(); ++i) {
+		if (first_moves[i].first > first_moves[eldest].first) {
+			eldest = i;
+		}
+	}
+	search_root_moves({ eldest });
+	// As in SearchRootMoves(), moves that tie with the eldest still get their exact value
+	root_alpha = first_moves[eldest].first - 1;
+	std::vector<size_t> younger;
+	for (size_t i = 0; i < first_moves.size(); ++i) {
+		if (i != eldest) {
+			younger.push_back(i);
+		}
+	}
+	search_root_moves(younger);
+	return ChooseRootMove(board, first_moves);
+}
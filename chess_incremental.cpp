@@ -0,0 +1,319 @@
+#include "chess.h"
+#include "bitboard.h"
+#include "board_geometry.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+// State that PlaceTile() keeps in line with tiles_ on every change of the board:
+// bitboards (8x8 only), king squares, per-team piece lists, material and piece-square scores, the game phase,
+// attack maps, the tile part of the Zobrist key and the pawn key
+// An attack map holds for every tile the number of pieces of a team that attack it
+
+namespace {
+
+	bool IsPlayingTeam(ChessTeam team) {
+		return team == ChessTeam::WHITE || team == ChessTeam::BLACK;
+	}
+
+	// Can a piece attack along a ray from any distance
+	bool SlidesAlong(ChessPiece piece, int ray) {
+		if (piece == ChessPiece::QUEEN) {
+			return true;
+		}
+		return piece == ((ray < BoardGeometry::ORTHOGONAL_RAYS_END) ? ChessPiece::ROOK : ChessPiece::BISHOP);
+	}
+}
+
+// Is a tile attacked by at least one piece of 'attacker', out of bounds tiles never are
+// Answered from attack maps that are kept up to date on every change of the board
+bool Chess::IsSquareAttacked(ChessTeam attacker, int row, int column) const {
+	if (CheckOutOfBounds(row, column) || !IsPlayingTeam(attacker)) {
+		return false;
+	}
+	return AttackCount(attacker, row * columns_ + column) > 0;
+}
+
+// Tiles holding pieces of a team, kept up to date on every change of the board. NEUTRAL pieces are not listed
+PieceList Chess::GetPieces(ChessTeam team) const {
+	std::pair<const uint16_t*, const uint16_t*> squares = PieceSquares(team);
+	return { squares.first, squares.second, columns_ };
+}
+
+// Does a team have a piece other than pawns and kings
+bool Chess::HasPiecesBeyondPawns(ChessTeam team) const {
+	std::pair<const uint16_t*, const uint16_t*> squares = PieceSquares(team);
+	return std::any_of(squares.first, squares.second, [this](uint16_t square) {
+		ChessPiece piece = tiles_[square].Piece();
+		return piece != ChessPiece::PAWN && piece != ChessPiece::KING;
+	});
+}
+
+// [first, last) of the piece_list_ part holding a team
+std::pair<const uint16_t*, const uint16_t*> Chess::PieceSquares(ChessTeam team) const {
+	if (team == ChessTeam::WHITE) {
+		return { piece_list_, piece_list_ + piece_counts_[int(team)] };
+	}
+	if (team == ChessTeam::BLACK) {
+		return { piece_list_ + GetTileCount() - piece_counts_[int(team)], piece_list_ + GetTileCount() };
+	}
+	return { piece_list_, piece_list_ };
+}
+
+void Chess::PlaceTile(int square, PackedTile tile) {
+	PackedTile previous = tiles_[square];
+	if (previous == tile) {
+		return;
+	}
+	bool was_occupied = (previous.Piece() != ChessPiece::EMPTY);
+	bool is_occupied = (tile.Piece() != ChessPiece::EMPTY);
+
+	// Attacks of the leaving piece are walked with the board as it was, those of the new one as it becomes
+	if (was_occupied) {
+		AddPieceAttacks(square, previous, -1);
+	}
+	if (was_occupied != is_occupied) {
+		ShadeRaysThrough(square, is_occupied ? -1 : 1);
+	}
+	if (HasBitboards()) {
+		Bitboard bit = SquareBit(square);
+		if (was_occupied) {
+			team_bitboards_[int(previous.Team())] &= ~bit;
+			piece_bitboards_[int(previous.Piece())] &= ~bit;
+		}
+		if (is_occupied) {
+			team_bitboards_[int(tile.Team())] |= bit;
+			piece_bitboards_[int(tile.Piece())] |= bit;
+		}
+	}
+	// A piece changing its type or has_moved flag keeps its place in the list
+	ChessTeam previous_team = was_occupied ? previous.Team() : ChessTeam::NEUTRAL;
+	ChessTeam team = is_occupied ? tile.Team() : ChessTeam::NEUTRAL;
+	if (previous_team != team) {
+		RemoveFromPieceList(previous_team, square);
+		AddToPieceList(team, square);
+	}
+	tiles_[square] = tile;
+	material_[int(previous.Team())] -= PieceValue(previous.Piece());
+	material_[int(tile.Team())] += PieceValue(tile.Piece());
+	for (int phase = 0; phase < BoardGeometry::PHASE_COUNT; ++phase) {
+		square_scores_[phase][int(previous.Team())] -= SquareScore(phase, square, previous);
+		square_scores_[phase][int(tile.Team())] += SquareScore(phase, square, tile);
+	}
+	phase_ += (IsPlayingTeam(team) ? PhaseWeight(tile.Piece()) : 0) -
+		(IsPlayingTeam(previous_team) ? PhaseWeight(previous.Piece()) : 0);
+	zobrist_key_ ^= TileKey(square, previous) ^ TileKey(square, tile);
+	pawn_key_ ^= PawnKey(square, previous) ^ PawnKey(square, tile);
+	if (is_occupied) {
+		AddPieceAttacks(square, tile, 1);
+	}
+	TrackKing(square, previous, false);
+	TrackKing(square, tile, true);
+	if (tile_observer_ != nullptr) {
+		tile_observer_->OnTileChanged(square, previous, tile);
+	}
+}
+
+// Recomputes everything PlaceTile() maintains from tiles_ alone
+void Chess::RebuildIncrementalState() {
+	RebuildBitboards();
+	std::fill(attack_counts_, attack_counts_ + 2 * GetTileCount(), 0);
+	std::fill(std::begin(king_squares_), std::end(king_squares_), -1);
+	std::fill(std::begin(king_counts_), std::end(king_counts_), 0);
+	std::fill(std::begin(piece_counts_), std::end(piece_counts_), 0);
+	std::fill(std::begin(material_), std::end(material_), 0);
+	std::memset(square_scores_, 0, sizeof(square_scores_));
+	phase_ = 0;
+	pawn_key_ = 0;
+	for (int square = 0; square < GetTileCount(); ++square) {
+		if (tiles_[square].Piece() != ChessPiece::EMPTY) {
+			AddPieceAttacks(square, tiles_[square], 1);
+			TrackKing(square, tiles_[square], true);
+			AddToPieceList(tiles_[square].Team(), square);
+			material_[int(tiles_[square].Team())] += PieceValue(tiles_[square].Piece());
+			pawn_key_ ^= PawnKey(square, tiles_[square]);
+			for (int phase = 0; phase < BoardGeometry::PHASE_COUNT; ++phase) {
+				square_scores_[phase][int(tiles_[square].Team())] += SquareScore(phase, square, tiles_[square]);
+			}
+			if (IsPlayingTeam(tiles_[square].Team())) {
+				phase_ += PhaseWeight(tiles_[square].Piece());
+			}
+		}
+	}
+	zobrist_key_ = ComputeZobristKey();
+	if (tile_observer_ != nullptr) {
+		tile_observer_->OnBoardRebuilt();
+	}
+}
+
+// Zobrist key of the position from scratch
+uint64_t Chess::ComputeZobristKey() const {
+	uint64_t key = is_whites_move_ ? 0 : geometry_->SideKey();
+	if (en_passant_.first) {
+		key ^= geometry_->EnPassantKey(en_passant_.second.second);
+	}
+	for (int square = 0; square < GetTileCount(); ++square) {
+		key ^= TileKey(square, tiles_[square]);
+	}
+	return key;
+}
+
+// Expects square to hold a piece of team
+void Chess::AddToPieceList(ChessTeam team, int square) {
+	if (!IsPlayingTeam(team)) {
+		return;
+	}
+	int count = piece_counts_[int(team)]++;
+	int slot = (team == ChessTeam::WHITE) ? count : GetTileCount() - 1 - count;
+	piece_list_[slot] = uint16_t(square);
+	piece_slots_[square] = uint16_t(slot);
+}
+
+// The last piece of the list takes the freed slot
+void Chess::RemoveFromPieceList(ChessTeam team, int square) {
+	if (!IsPlayingTeam(team)) {
+		return;
+	}
+	int count = --piece_counts_[int(team)];
+	int last_slot = (team == ChessTeam::WHITE) ? count : GetTileCount() - 1 - count;
+	int slot = piece_slots_[square];
+	int moved_square = piece_list_[last_slot];
+	piece_list_[slot] = uint16_t(moved_square);
+	piece_slots_[moved_square] = uint16_t(slot);
+}
+
+// Adds delta to the attack count of every tile the piece at square attacks
+void Chess::AddPieceAttacks(int square, PackedTile piece, int delta) {
+	if (!IsPlayingTeam(piece.Team())) {
+		return;
+	}
+	const BoardGeometry& geometry = *geometry_;
+	uint8_t* counts = attack_counts_ + (int(piece.Team()) - 1) * GetTileCount();
+	int rays_begin = 0;
+	int rays_end = BoardGeometry::RAY_COUNT;
+	bool slides = true;
+	switch (piece.Piece()) {
+	default:
+		return;
+	case ChessPiece::KNIGHT:
+	{
+		uint8_t jumps = geometry.KnightJumps(square);
+		for (int jump = 0; jump < BoardGeometry::KNIGHT_JUMP_COUNT; ++jump) {
+			if (jumps & (1 << jump)) {
+				uint8_t& count = counts[square + geometry.KnightStep(jump)];
+				count = uint8_t(count + delta);
+			}
+		}
+		return;
+	}
+	case ChessPiece::PAWN:
+		rays_begin = (piece.Team() == ChessTeam::WHITE) ? 4 : 6;
+		rays_end = rays_begin + 2;
+		slides = false;
+		break;
+	case ChessPiece::KING:
+		slides = false;
+		break;
+	case ChessPiece::ROOK:
+		rays_end = BoardGeometry::ORTHOGONAL_RAYS_END;
+		break;
+	case ChessPiece::BISHOP:
+		rays_begin = BoardGeometry::ORTHOGONAL_RAYS_END;
+		break;
+	case ChessPiece::QUEEN:
+		break;
+	}
+	for (int ray = rays_begin; ray < rays_end; ++ray) {
+		int step = geometry.RayStep(ray);
+		int length = geometry.RayLength(square, ray);
+		if (!slides) {
+			length = std::min(length, 1);
+		}
+		int pos = square;
+		for (int distance = 1; distance <= length; ++distance) {
+			pos += step;
+			counts[pos] = uint8_t(counts[pos] + delta);
+			if (tiles_[pos].Piece() != ChessPiece::EMPTY) {
+				break;
+			}
+		}
+	}
+}
+
+// Sliders aiming at a square reach past it once it empties (delta = 1) and stop at it once it fills (delta = -1)
+// The square itself must not be counted as occupied yet / anymore
+void Chess::ShadeRaysThrough(int square, int delta) {
+	const BoardGeometry& geometry = *geometry_;
+	// First piece along a ray, -1 if there is none. reach is the number of tiles up to it or to the border
+	auto first_piece = [&](int ray, int& reach) {
+		int step = geometry.RayStep(ray);
+		int length = geometry.RayLength(square, ray);
+		int pos = square;
+		for (reach = 1; reach <= length; ++reach) {
+			pos += step;
+			if (tiles_[pos].Piece() != ChessPiece::EMPTY) {
+				return pos;
+			}
+		}
+		reach = length;
+		return -1;
+	};
+	auto shade = [&](int slider, int ray, int reach) {
+		PackedTile piece = tiles_[slider];
+		if (!IsPlayingTeam(piece.Team()) || !SlidesAlong(piece.Piece(), ray)) {
+			return;
+		}
+		uint8_t* counts = attack_counts_ + (int(piece.Team()) - 1) * GetTileCount();
+		int step = geometry.RayStep(ray);
+		int pos = square;
+		for (int distance = 1; distance <= reach; ++distance) {
+			pos += step;
+			counts[pos] = uint8_t(counts[pos] + delta);
+		}
+	};
+
+	// Both directions of a line are looked at together, a slider on one side shades the other side
+	for (int ray = 0; ray < BoardGeometry::RAY_COUNT; ++ray) {
+		int back_ray = BoardGeometry::OppositeRay(ray);
+		if (back_ray < ray) {
+			continue;
+		}
+		int reach = 0;
+		int back_reach = 0;
+		int ahead = first_piece(ray, reach);
+		int behind = first_piece(back_ray, back_reach);
+		if (ahead >= 0) {
+			shade(ahead, back_ray, back_reach);
+		}
+		if (behind >= 0) {
+			shade(behind, ray, reach);
+		}
+	}
+}
+
+// King squares follow kings placed and removed. A removed first king hands over to the next one, if any
+void Chess::TrackKing(int square, PackedTile piece, bool is_placed) {
+	if (piece.Piece() != ChessPiece::KING || !IsPlayingTeam(piece.Team())) {
+		return;
+	}
+	int team = int(piece.Team());
+	if (is_placed) {
+		++king_counts_[team];
+		if (king_squares_[team] < 0 || square < king_squares_[team]) {
+			king_squares_[team] = square;
+		}
+		return;
+	}
+	--king_counts_[team];
+	if (king_squares_[team] != square) {
+		return;
+	}
+	king_squares_[team] = -1;
+	for (int pos = 0; king_counts_[team] > 0 && pos < GetTileCount(); ++pos) {
+		if (tiles_[pos].Piece() == ChessPiece::KING && int(tiles_[pos].Team()) == team) {
+			king_squares_[team] = pos;
+			break;
+		}
+	}
+}
@@ -0,0 +1,631 @@
+#include "chess.h"
+#include "board_geometry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <vector>
+
+using namespace std;
+
+// Legal move generation. Checks and pins against the king are found once per position (KingSafety),
+// after which every candidate move is accepted or rejected without touching the board
+
+namespace {
+
+	ChessTeam EnemyTeam(ChessTeam team) {
+		return (team == ChessTeam::WHITE) ? ChessTeam::BLACK : ChessTeam::WHITE;
+	}
+
+	// Can a piece attack along a ray from any distance
+	bool SlidesAlong(ChessPiece piece, int ray) {
+		if (piece == ChessPiece::QUEEN) {
+			return true;
+		}
+		return piece == ((ray < BoardGeometry::ORTHOGONAL_RAYS_END) ? ChessPiece::ROOK : ChessPiece::BISHOP);
+	}
+
+	// Rays from a target towards the pawns of 'attacker' that capture onto it
+	int PawnAttackRaysBegin(ChessTeam attacker) {
+		return (attacker == ChessTeam::WHITE) ? 6 : 4;
+	}
+
+	// First and last row of the 8x8 board, where pawns promote
+	constexpr Bitboard PROMOTION_ROWS = Bitboard(0xFF) | (Bitboard(0xFF) << (BITBOARD_SQUARES - BITBOARD_SIDE));
+}
+
+// Gives all possible destination tiles on the board for a selected piece
+deque<pair<int, int>> Chess::GetPossibleDestTiles(int n_input, int m_input) const {
+	deque<pair<int, int>> output;
+	if (!CheckValidPieceSelected(n_input, m_input)) {
+		return output;
+	}
+	int square = n_input * columns_ + m_input;
+	KingSafety safety = ComputeKingSafety(tiles_[square].Team());
+	if (HasBitboards()) {
+		Bitboard targets = BitboardLegalTargets(square, safety);
+		while (targets) {
+			int dest = PopLowestSquare(targets);
+			output.push_back({ dest / BITBOARD_SIDE, dest % BITBOARD_SIDE });
+		}
+		return output;
+	}
+
+	// Generic boards: walk rays and jumps of the piece and keep moves that leave own king safe
+	std::vector<int> legal_squares;
+	ForEachPseudoTarget(square, [&](int dest) {
+		if (IsLegalPseudoMove(safety, square, dest)) {
+			legal_squares.push_back(dest);
+		}
+	});
+	// Same row-major order as the bitboard path
+	std::sort(legal_squares.begin(), legal_squares.end());
+	for (int dest : legal_squares) {
+		output.push_back({ dest / columns_, dest % columns_ });
+	}
+	return output;
+}
+
+// Every legal move of the side to move, replaces the previous content of 'moves'
+// Moves are ordered by origin, then destination tile (row-major). Each promoting pawn move comes
+// four times: queen, knight, bishop, rook
+// 'kind' limits the moves to captures or quiet moves, so a search can generate them one group at a time
+void Chess::GenerateLegalMoves(MoveBuffer& moves, MoveKind kind) const {
+	moves.clear();
+	ChessTeam team = WhoseMove();
+	KingSafety safety = ComputeKingSafety(team);
+	if (HasBitboards()) {
+		Bitboard enemies = team_bitboards_[int(EnemyTeam(team))];
+		Bitboard pawn_captures = enemies | PROMOTION_ROWS;
+		if (en_passant_.first) {
+			pawn_captures |= SquareBit(en_passant_.second.first * BITBOARD_SIDE + en_passant_.second.second);
+		}
+		// Bit order already is row-major
+		Bitboard pieces = team_bitboards_[int(team)];
+		while (pieces) {
+			int from = PopLowestSquare(pieces);
+			Bitboard targets = BitboardLegalTargets(from, safety);
+			Bitboard captures = (tiles_[from].Piece() == ChessPiece::PAWN) ? pawn_captures : enemies;
+			if (kind == MoveKind::CAPTURES) {
+				targets &= captures;
+			}
+			else if (kind == MoveKind::QUIETS) {
+				targets &= ~captures;
+			}
+			while (targets) {
+				AddLegalMove(moves, from, PopLowestSquare(targets));
+			}
+		}
+		return;
+	}
+
+	std::pair<const uint16_t*, const uint16_t*> squares = PieceSquares(team);
+	for (const uint16_t* square = squares.first; square != squares.second; ++square) {
+		int from = *square;
+		ForEachPseudoTarget(from, [&](int dest) {
+			if (kind != MoveKind::ALL && IsCaptureOrPromotion(from, dest) != (kind == MoveKind::CAPTURES)) {
+				return;
+			}
+			if (IsLegalPseudoMove(safety, from, dest)) {
+				AddLegalMove(moves, from, dest);
+			}
+		});
+	}
+	// Piece lists and rays are in no particular order, sort to the same order as the bitboard path
+	auto order_key = [](Move move) {
+		constexpr uint8_t PROMOTION_RANKS[] = { 0, 0, 3, 2, 1, 0, 0 };    // Indexed by ChessPiece
+		return (uint64_t(move.From()) << 32) | (uint64_t(move.To()) << 8) | PROMOTION_RANKS[int(move.Promotion())];
+	};
+	std::sort(moves.begin(), moves.end(), [&](Move first, Move second) {
+		return order_key(first) < order_key(second);
+	});
+}
+
+// Would GenerateLegalMoves() give this move, flags and promotion piece included
+// Meant for moves kept from other positions, e.g. killer moves of a search
+bool Chess::IsMoveLegal(Move move) const {
+	int from = move.From();
+	int dest = move.To();
+	if (from >= GetTileCount() || dest >= GetTileCount() || tiles_[from].Piece() == ChessPiece::EMPTY ||
+		tiles_[from].Team() != WhoseMove()) {
+		return false;
+	}
+	if (DescribeMove(from, dest).Flags() != move.Flags() || !IsLegalMove(from, dest / columns_, dest % columns_)) {
+		return false;
+	}
+	int dest_row = dest / columns_;
+	bool promotes = tiles_[from].Piece() == ChessPiece::PAWN && (dest_row == 0 || dest_row == rows_ - 1);
+	if (!promotes) {
+		return !move.IsPromotion();
+	}
+	ChessPiece promotion = move.Promotion();
+	return promotion == ChessPiece::QUEEN || promotion == ChessPiece::KNIGHT || promotion == ChessPiece::BISHOP ||
+		promotion == ChessPiece::ROOK;
+}
+
+// Does a move from one tile to another belong to MoveKind::CAPTURES, the move itself is not checked
+bool Chess::IsCaptureOrPromotion(int from, int dest) const {
+	PackedTile piece = tiles_[from];
+	PackedTile target = tiles_[dest];
+	if (target.Piece() != ChessPiece::EMPTY && target.Team() != piece.Team()) {
+		return true;
+	}
+	if (piece.Piece() != ChessPiece::PAWN) {
+		return false;
+	}
+	// A pawn leaving its column onto an empty tile takes en passant
+	int dest_row = dest / columns_;
+	return dest_row == 0 || dest_row == rows_ - 1 || from % columns_ != dest % columns_;
+}
+
+// Appends a legal move with its flags, or all four promotions of it
+void Chess::AddLegalMove(MoveBuffer& moves, int from, int dest) const {
+	Move move = DescribeMove(from, dest);
+	int dest_row = dest / columns_;
+	if (tiles_[from].Piece() == ChessPiece::PAWN && (dest_row == 0 || dest_row == rows_ - 1)) {
+		for (ChessPiece promotion : { ChessPiece::QUEEN, ChessPiece::KNIGHT, ChessPiece::BISHOP, ChessPiece::ROOK }) {
+			moves.push_back(Move(from, dest, promotion, move.Flags()));
+		}
+		return;
+	}
+	moves.push_back(move);
+}
+
+// Flags a move from one tile to another would get from GenerateLegalMoves(), without a promotion piece
+Move Chess::DescribeMove(int from, int dest) const {
+	PackedTile piece = tiles_[from];
+	PackedTile target = tiles_[dest];
+	uint32_t flags = 0;
+	if (target.Piece() != ChessPiece::EMPTY && target.Team() != piece.Team()) {
+		flags |= Move::CAPTURE;
+	}
+	int column_difference = std::abs(from % columns_ - dest % columns_);
+	if (piece.Piece() == ChessPiece::KING && column_difference == 2) {
+		flags |= Move::CASTLING;
+	}
+	if (piece.Piece() == ChessPiece::PAWN && target.Piece() == ChessPiece::EMPTY && column_difference == 1) {
+		flags |= Move::CAPTURE | Move::EN_PASSANT;
+	}
+	return Move(from, dest, ChessPiece::EMPTY, flags);
+}
+
+// Full rule check of a move for the piece at square 'from', turn sequence aside
+bool Chess::IsLegalMove(int from, int n_dest, int m_dest) const {
+	if (CheckOutOfBounds(n_dest, m_dest)) {
+		return false;
+	}
+	KingSafety safety = ComputeKingSafety(tiles_[from].Team());
+	if (HasBitboards()) {
+		return BitboardLegalTargets(from, safety) & SquareBit(n_dest * BITBOARD_SIDE + m_dest);
+	}
+	int n_input = from / columns_;
+	int m_input = from % columns_;
+	if (!CheckLegalPieceMove(n_input, m_input, n_dest, m_dest)) {
+		return false;
+	}
+	ChessPiece piece = tiles_[from].Piece();
+	bool is_castling = (piece == ChessPiece::KING && std::abs(m_input - m_dest) == 2);
+	bool is_en_passant = (piece == ChessPiece::PAWN && en_passant_.first &&
+		n_dest == en_passant_.second.first && m_dest == en_passant_.second.second);
+	if (is_en_passant && TileAt(n_input, m_dest).Piece() == ChessPiece::EMPTY) {
+		return false;
+	}
+	if (!is_castling && !is_en_passant && CheckCollision(n_input, m_input, n_dest, m_dest)) {
+		return false;
+	}
+	return IsLegalPseudoMove(safety, from, n_dest * columns_ + m_dest);
+}
+
+Chess::KingSafety Chess::ComputeKingSafety(ChessTeam team) const {
+	if (HasBitboards()) {
+		return BitboardKingSafety(team);
+	}
+	KingSafety safety;
+	if (team == ChessTeam::NEUTRAL || king_squares_[int(team)] < 0) {
+		return safety;
+	}
+	safety.king_square = king_squares_[int(team)];
+
+	const BoardGeometry& geometry = *geometry_;
+	ChessTeam enemy = EnemyTeam(team);
+	int pawn_rays_begin = PawnAttackRaysBegin(enemy);
+	for (int ray = 0; ray < BoardGeometry::RAY_COUNT; ++ray) {
+		int step = geometry.RayStep(ray);
+		int length = geometry.RayLength(safety.king_square, ray);
+		int pos = safety.king_square;
+		int own_blocker = -1;
+		for (int distance = 1; distance <= length; ++distance) {
+			pos += step;
+			PackedTile tile = tiles_[pos];
+			if (tile.Piece() == ChessPiece::EMPTY) {
+				continue;
+			}
+			if (tile.Team() != enemy) {
+				if (own_blocker >= 0) {
+					break;
+				}
+				own_blocker = pos;
+				continue;
+			}
+			bool slides = SlidesAlong(tile.Piece(), ray);
+			if (own_blocker >= 0) {
+				if (slides) {
+					safety.pinned_squares[safety.pin_count] = own_blocker;
+					safety.pin_rays[safety.pin_count] = ray;
+					++safety.pin_count;
+				}
+			}
+			else if (slides) {
+				++safety.checker_count;
+				safety.checker_square = pos;
+				safety.check_ray = ray;
+				safety.check_distance = distance;
+				safety.xray_rays |= uint8_t(1 << BoardGeometry::OppositeRay(ray));
+			}
+			else if (distance == 1 && (tile.Piece() == ChessPiece::KING ||
+				(tile.Piece() == ChessPiece::PAWN && ray >= pawn_rays_begin && ray < pawn_rays_begin + 2))) {
+				++safety.checker_count;
+				safety.checker_square = pos;
+				safety.check_ray = -1;
+			}
+			break;
+		}
+	}
+	uint8_t jumps = geometry.KnightJumps(safety.king_square);
+	for (int jump = 0; jump < BoardGeometry::KNIGHT_JUMP_COUNT; ++jump) {
+		if (jumps & (1 << jump)) {
+			int pos = safety.king_square + geometry.KnightStep(jump);
+			if (tiles_[pos].Team() == enemy && tiles_[pos].Piece() == ChessPiece::KNIGHT) {
+				++safety.checker_count;
+				safety.checker_square = pos;
+				safety.check_ray = -1;
+			}
+		}
+	}
+	return safety;
+}
+
+// Returns k if square = origin + k * (ray offset) for some k > 0, otherwise 0
+int Chess::RayDistance(int origin, int ray, int square) const {
+	int n_dif = square / columns_ - origin / columns_;
+	int m_dif = square % columns_ - origin % columns_;
+	const int* offset = BoardGeometry::RAY_OFFSETS[ray];
+	int distance = (offset[0] != 0) ? n_dif * offset[0] : m_dif * offset[1];
+	if (distance <= 0 || n_dif != distance * offset[0] || m_dif != distance * offset[1]) {
+		return 0;
+	}
+	return distance;
+}
+
+// For moves of pieces other than the king, en passant aside
+bool Chess::KeepsKingSafe(const KingSafety& safety, int from, int dest) const {
+	if (safety.king_square < 0) {
+		return true;
+	}
+	if (safety.checker_count > 1) {
+		return false;
+	}
+	if (safety.checker_count == 1 && dest != safety.checker_square) {
+		// Only a block between a sliding checker and the king helps
+		if (safety.check_ray < 0) {
+			return false;
+		}
+		int distance = RayDistance(safety.king_square, safety.check_ray, dest);
+		if (distance == 0 || distance >= safety.check_distance) {
+			return false;
+		}
+	}
+	for (int i = 0; i < safety.pin_count; ++i) {
+		if (safety.pinned_squares[i] == from) {
+			return RayDistance(safety.king_square, safety.pin_rays[i], dest) > 0;
+		}
+	}
+	return true;
+}
+
+// Expects dest to be a pseudo target of the piece at 'from', see ForEachPseudoTarget()
+bool Chess::IsLegalPseudoMove(const KingSafety& safety, int from, int dest) const {
+	PackedTile piece = tiles_[from];
+	ChessTeam enemy = EnemyTeam(piece.Team());
+	if (piece.Piece() == ChessPiece::KING) {
+		if (std::abs(from % columns_ - dest % columns_) == 2) {
+			return CastlingAllowed(from, dest);
+		}
+		if (from != safety.king_square) {
+			return !IsAttackedBy(enemy, dest, from);
+		}
+		// Attack maps see everything but the tile the king hides from a sliding checker behind itself
+		for (int ray = 0; ray < BoardGeometry::RAY_COUNT; ++ray) {
+			if ((safety.xray_rays & (1 << ray)) && geometry_->RayLength(from, ray) > 0 &&
+				dest == from + geometry_->RayStep(ray)) {
+				return false;
+			}
+		}
+		return AttackCount(enemy, dest) == 0;
+	}
+	if (piece.Piece() == ChessPiece::PAWN && en_passant_.first &&
+		dest == en_passant_.second.first * columns_ + en_passant_.second.second) {
+		// Two pawns leave the same row at once, simply look at the king afterwards
+		if (safety.king_square < 0) {
+			return true;
+		}
+		int captured = from - from % columns_ + dest % columns_;
+		return !IsAttackedBy(enemy, safety.king_square, from, captured, dest);
+	}
+	return KeepsKingSafe(safety, from, dest);
+}
+
+// King at king_square moves two tiles towards dest_square, the first rook in that direction jumps over it
+// Neither may have moved, tiles between them must be empty and the king can't be checked on its path
+bool Chess::CastlingAllowed(int king_square, int dest_square) const {
+	PackedTile king = tiles_[king_square];
+	ChessTeam enemy = EnemyTeam(king.Team());
+	if (king.HasMoved() || AttackCount(enemy, king_square) > 0) {
+		return false;
+	}
+	int row_start = king_square - king_square % columns_;
+	int increment = (dest_square > king_square) ? 1 : -1;
+	int rook_square = -1;
+	for (int pos = king_square + increment; pos >= row_start && pos < row_start + columns_; pos += increment) {
+		if (tiles_[pos].Piece() == ChessPiece::ROOK) {
+			rook_square = pos;
+			break;
+		}
+		if (tiles_[pos].Piece() != ChessPiece::EMPTY) {
+			break;
+		}
+	}
+	if (rook_square < 0 || tiles_[rook_square].HasMoved()) {
+		return false;
+	}
+	if (dest_square != rook_square && tiles_[dest_square].Piece() != ChessPiece::EMPTY) {
+		return false;
+	}
+	for (int path = king_square + increment; ; path += increment) {
+		if (IsAttackedBy(enemy, path, king_square, rook_square)) {
+			return false;
+		}
+		if (path == dest_square) {
+			return true;
+		}
+	}
+}
+
+// Walks rays and knight jumps outwards from a square looking for pieces of a team that reach it
+// Tiles 'vacated' and 'vacated_other' are treated as empty, tile 'filled' as blocked by a non-attacker
+bool Chess::IsAttackedBy(ChessTeam attacker, int square, int vacated, int vacated_other, int filled) const {
+	const BoardGeometry& geometry = *geometry_;
+	int pawn_rays_begin = PawnAttackRaysBegin(attacker);
+	for (int ray = 0; ray < BoardGeometry::RAY_COUNT; ++ray) {
+		int step = geometry.RayStep(ray);
+		int length = geometry.RayLength(square, ray);
+		int pos = square;
+		for (int distance = 1; distance <= length; ++distance) {
+			pos += step;
+			if (pos == filled) {
+				break;
+			}
+			PackedTile tile = tiles_[pos];
+			if (tile.Piece() == ChessPiece::EMPTY || pos == vacated || pos == vacated_other) {
+				continue;
+			}
+			if (tile.Team() == attacker) {
+				ChessPiece piece = tile.Piece();
+				if (SlidesAlong(piece, ray) ||
+					(distance == 1 && piece == ChessPiece::KING) ||
+					(distance == 1 && piece == ChessPiece::PAWN && ray >= pawn_rays_begin && ray < pawn_rays_begin + 2)) {
+					return true;
+				}
+			}
+			break;
+		}
+	}
+	uint8_t jumps = geometry.KnightJumps(square);
+	for (int jump = 0; jump < BoardGeometry::KNIGHT_JUMP_COUNT; ++jump) {
+		if (jumps & (1 << jump)) {
+			int pos = square + geometry.KnightStep(jump);
+			if (pos != vacated && pos != vacated_other && pos != filled &&
+				tiles_[pos].Team() == attacker && tiles_[pos].Piece() == ChessPiece::KNIGHT) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// Square of the cheapest piece of 'attacker' that reaches square, -1 if none
+// Tiles listed in 'removed' are treated as empty, which lets pieces behind them through
+int Chess::CheapestAttacker(ChessTeam attacker, int square, const int* removed, int removed_count) const {
+	const BoardGeometry& geometry = *geometry_;
+	auto is_removed = [&](int pos) {
+		return std::find(removed, removed + removed_count, pos) != removed + removed_count;
+	};
+	// The king reaches as the most valuable piece, it only captures when nothing else can
+	auto rank = [](ChessPiece piece) {
+		return (piece == ChessPiece::KING) ? 100 : PieceValue(piece);
+	};
+	int best = -1;
+	int pawn_rays_begin = PawnAttackRaysBegin(attacker);
+	for (int ray = 0; ray < BoardGeometry::RAY_COUNT; ++ray) {
+		int step = geometry.RayStep(ray);
+		int length = geometry.RayLength(square, ray);
+		int pos = square;
+		for (int distance = 1; distance <= length; ++distance) {
+			pos += step;
+			PackedTile tile = tiles_[pos];
+			if (tile.Piece() == ChessPiece::EMPTY || is_removed(pos)) {
+				continue;
+			}
+			if (tile.Team() == attacker) {
+				ChessPiece piece = tile.Piece();
+				if ((SlidesAlong(piece, ray) ||
+					(distance == 1 && piece == ChessPiece::KING) ||
+					(distance == 1 && piece == ChessPiece::PAWN && ray >= pawn_rays_begin && ray < pawn_rays_begin + 2)) &&
+					(best < 0 || rank(piece) < rank(tiles_[best].Piece()))) {
+					best = pos;
+				}
+			}
+			break;
+		}
+	}
+	uint8_t jumps = geometry.KnightJumps(square);
+	for (int jump = 0; jump < BoardGeometry::KNIGHT_JUMP_COUNT; ++jump) {
+		if (jumps & (1 << jump)) {
+			int pos = square + geometry.KnightStep(jump);
+			if (tiles_[pos].Team() == attacker && tiles_[pos].Piece() == ChessPiece::KNIGHT && !is_removed(pos) &&
+				(best < 0 || rank(ChessPiece::KNIGHT) < rank(tiles_[best].Piece()))) {
+				best = pos;
+			}
+		}
+	}
+	return best;
+}
+
+// Both teams take turns capturing on the destination with their cheapest piece. gains[i] is what the side
+// making capture i has won so far, the last capture of the list is played only if it pays off, and so on back
+// to the first one (a swap list)
+int Chess::StaticExchange(Move move) const {
+	constexpr int MAX_EXCHANGE = 32;
+	int from = move.From();
+	int dest = move.To();
+	PackedTile moved = tiles_[from];
+	int removed[MAX_EXCHANGE + 2];
+	int removed_count = 0;
+	removed[removed_count++] = from;
+
+	int gains[MAX_EXCHANGE];
+	gains[0] = PieceValue(tiles_[dest].Piece());
+	if (move.IsEnPassant()) {
+		removed[removed_count++] = from - from % columns_ + dest % columns_;
+		gains[0] = PieceValue(ChessPiece::PAWN);
+	}
+	// Value of the piece standing on dest, the next one to be captured
+	int on_dest = PieceValue(moved.Piece());
+	if (move.IsPromotion()) {
+		gains[0] += PieceValue(move.Promotion()) - PieceValue(ChessPiece::PAWN);
+		on_dest = PieceValue(move.Promotion());
+	}
+
+	ChessTeam side = EnemyTeam(moved.Team());
+	int depth = 0;
+	while (depth + 1 < MAX_EXCHANGE) {
+		int attacker = CheapestAttacker(side, dest, removed, removed_count);
+		if (attacker < 0) {
+			break;
+		}
+		ChessPiece piece = tiles_[attacker].Piece();
+		removed[removed_count++] = attacker;
+		// A king can't capture onto a tile the other team still reaches
+		if (piece == ChessPiece::KING && CheapestAttacker(EnemyTeam(side), dest, removed, removed_count) >= 0) {
+			break;
+		}
+		++depth;
+		gains[depth] = on_dest - gains[depth - 1];
+		on_dest = PieceValue(piece);
+		side = EnemyTeam(side);
+	}
+	while (depth > 0) {
+		gains[depth - 1] = -std::max(-gains[depth - 1], gains[depth]);
+		--depth;
+	}
+	return gains[0];
+}
+
+// Calls visit(dest_square) for every tile a piece at square can reach by its movement rules
+// Own king safety is not checked. Castling destinations are given without checking castling requirements
+template <typename Visitor>
+void Chess::ForEachPseudoTarget(int square, Visitor&& visit) const {
+	const BoardGeometry& geometry = *geometry_;
+	PackedTile piece = tiles_[square];
+	ChessTeam team = piece.Team();
+	int rays_begin = 0;
+	int rays_end = BoardGeometry::RAY_COUNT;
+	switch (piece.Piece()) {
+	default:
+		return;
+	case ChessPiece::KNIGHT:
+	{
+		uint8_t jumps = geometry.KnightJumps(square);
+		for (int jump = 0; jump < BoardGeometry::KNIGHT_JUMP_COUNT; ++jump) {
+			int dest = square + geometry.KnightStep(jump);
+			if ((jumps & (1 << jump)) && tiles_[dest].Team() != team) {
+				visit(dest);
+			}
+		}
+		return;
+	}
+	case ChessPiece::KING:
+	{
+		for (int ray = 0; ray < BoardGeometry::RAY_COUNT; ++ray) {
+			int dest = square + geometry.RayStep(ray);
+			if (geometry.RayLength(square, ray) > 0 && tiles_[dest].Team() != team) {
+				visit(dest);
+			}
+		}
+		int column = square % columns_;
+		if (column >= 2) {
+			visit(square - 2);
+		}
+		if (column + 2 < columns_) {
+			visit(square + 2);
+		}
+		return;
+	}
+	case ChessPiece::PAWN:
+	{
+		bool is_white = (team == ChessTeam::WHITE);
+		int forward_ray = is_white ? 0 : 1;
+		int forward_step = geometry.RayStep(forward_ray);
+		int forward_length = geometry.RayLength(square, forward_ray);
+		if (forward_length >= 1 && tiles_[square + forward_step].Piece() == ChessPiece::EMPTY) {
+			visit(square + forward_step);
+			if (!piece.HasMoved() && forward_length >= 2 &&
+				tiles_[square + 2 * forward_step].Piece() == ChessPiece::EMPTY) {
+				visit(square + 2 * forward_step);
+			}
+		}
+		int capture_rays_begin = is_white ? 4 : 6;
+		for (int ray = capture_rays_begin; ray < capture_rays_begin + 2; ++ray) {
+			if (geometry.RayLength(square, ray) == 0) {
+				continue;
+			}
+			int dest = square + geometry.RayStep(ray);
+			PackedTile dest_tile = tiles_[dest];
+			if (dest_tile.Piece() != ChessPiece::EMPTY) {
+				if (dest_tile.Team() != team) {
+					visit(dest);
+				}
+			}
+			else if (en_passant_.first && dest == en_passant_.second.first * columns_ + en_passant_.second.second &&
+				tiles_[square - square % columns_ + dest % columns_].Piece() != ChessPiece::EMPTY) {
+				visit(dest);
+			}
+		}
+		return;
+	}
+	case ChessPiece::ROOK:
+		rays_end = BoardGeometry::ORTHOGONAL_RAYS_END;
+		break;
+	case ChessPiece::BISHOP:
+		rays_begin = BoardGeometry::ORTHOGONAL_RAYS_END;
+		break;
+	case ChessPiece::QUEEN:
+		break;
+	}
+	for (int ray = rays_begin; ray < rays_end; ++ray) {
+		int step = geometry.RayStep(ray);
+		int length = geometry.RayLength(square, ray);
+		int dest = square;
+		for (int distance = 1; distance <= length; ++distance) {
+			dest += step;
+			PackedTile dest_tile = tiles_[dest];
+			if (dest_tile.Piece() != ChessPiece::EMPTY) {
+				if (dest_tile.Team() != team) {
+					visit(dest);
+				}
+				break;
+			}
+			visit(dest);
+		}
+	}
+}
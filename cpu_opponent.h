@@ -7,35 +7,29 @@
 class RandomMovesPlayer {
 public:
 
-	// Creates local array of tile coordinates that contain pieces of a specified team
-	// Class will not recognize newly created pieces of its team on the board
+	// Moves are generated from the board every turn, so promoted and captured pieces are accounted for
 	RandomMovesPlayer(Chess& board, const ChessTeam& team = ChessTeam::BLACK);
 
 	RandomMovesPlayer() = delete;
 
-	~RandomMovesPlayer() {
-		CleanUp();
-	}
-
 	// Moves random piece to a random tile in accordance with chess rules
 	// May or may not capture enemy pieces
 	void MovePiece();
 
-	// If available, makes a move that captures enemy piece
-	// If not, makes a random move that is guaranteed to not capture a piece
+	// If available, makes a move that captures enemy piece without losing material in the exchange that follows
+	// If not, makes a random move
 	void AgrMovePiece();
 
 private:
 	Chess* board_ = nullptr;
-	std::pair<int, int>* array_ptr_ = nullptr;
-	size_t size_ = 0;
-	size_t max_size_ = 0;
 	ChessTeam team_;
+	// Refilled every turn, kept to avoid allocations
+	MoveBuffer moves_;
+	MoveBuffer captures_;                // Captures of moves_ that don't lose material, see AgrMovePiece()
 
-	// Finds and removes pieces from database that no longer exist on the board
-	void RemoveCapturedPieces();
+	// Fills moves_ with legal moves of the team, returns 'false' if there are none or it is not the team's turn
+	bool CollectMoves();
 
-	void CleanUp() {
-		delete[] array_ptr_;
-	}
+	// Goes through Chess::MovePiece(), so derived boards see the move. Promotion piece is taken from the move
+	void Play(Move move);
 };
@@ -157,6 +157,13 @@ void ChessEngineTest2() {
 	int n_in, m_in;
 	int n_out, m_out;
 	FullMoveData move;
+	MoveOrdering ordering;
+	TranspositionTable table;
+	// Without the file the engine values positions by EvaluatePosition()
+	NnueNetwork network;
+	if (network.Load("nnue.bin")) {
+		cout << "Loaded nnue.bin\n";
+	}
 	for (int i = 0; i < 50; ++i) {
 		BoardVisualizerFunc(board);
 		std::cin >> n_in >> m_in;
@@ -166,7 +173,7 @@ void ChessEngineTest2() {
 			board.PawnPromotion(ChessPiece::QUEEN);
 		}
 		BoardVisualizerFunc(board);
-		move = PlayMoveOP(board, ChessTeam::BLACK, 5);
+		move = PlayMoveOP(board, ChessTeam::BLACK, 5, ordering, table, 1, &network);
 		board.MovePiece(move.own_move.start, move.own_move.end);
 		if (move.promotion_data.first) {
 			board.PawnPromotion(move.promotion_data.second);
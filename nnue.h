@@ -0,0 +1,371 @@
+#pragma once
+
+#include "chess.h"
+#include "piece_value_calculator.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Kernels are picked at compile time: AVX2 with -mavx2 (/arch:AVX2), SSSE3 with -mssse3, plain loops otherwise
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NNUE_USE_AVX2
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define NNUE_USE_SSSE3
+#endif
+
+// Weights of a small quantized NNUE network for the standard 8x8 board, read-only once loaded, so all search
+// threads may share one
+// Features are king-relative (HalfKP): own king square x piece kind x square, where a kind is one of five
+// pieces (kings are not features) of either the own team or the enemy. Each team sees the board from its
+// own side, black reads rows upside down
+// Layers: features -> HIDDEN int16 sums per team (the accumulator, see NnueAccumulator), then the clipped sums
+// of the side to move and of the other side -> L1 -> L2 -> 1, int8 weights with clipped ReLU in between
+class NnueNetwork {
+public:
+	static constexpr int SIDE = 8;
+	static constexpr int SQUARES = SIDE * SIDE;
+	static constexpr int PIECE_KINDS = 10;
+	static constexpr int FEATURES = SQUARES * PIECE_KINDS * SQUARES;
+	static constexpr int HIDDEN = 128;
+	static constexpr int L1 = 32;
+	static constexpr int L2 = 32;
+
+	// Sums of the int8 layers are shifted down by WEIGHT_SHIFT, clipped activations lie in [0, ACTIVATION_MAX]
+	// The output divided by OUTPUT_SCALE is in hundredths of a pawn
+	static constexpr int WEIGHT_SHIFT = 6;
+	static constexpr int ACTIVATION_MAX = 127;
+	static constexpr int OUTPUT_SCALE = 16;
+
+	// File layout, little-endian, no padding:
+	// FILE_MAGIC, uint32 FILE_VERSION, uint32 HIDDEN, uint32 L1, uint32 L2,
+	// int16 feature biases [HIDDEN], int16 feature weights [FEATURES][HIDDEN],
+	// int32 L1 biases [L1], int8 L1 weights [L1][2 * HIDDEN], int32 L2 biases [L2], int8 L2 weights [L2][L1],
+	// int32 output bias, int8 output weights [L2]
+	static constexpr char FILE_MAGIC[4] = { 'N', 'N', 'U', 'E' };
+	static constexpr uint32_t FILE_VERSION = 1;
+
+	// Only standard boards have features
+	static bool Supports(const Chess& board) {
+		return board.GetDimensions() == std::pair<int, int>(SIDE, SIDE);
+	}
+
+	// Feature of a piece (not a king) of a playing team seen by 'perspective' with its king on king_square
+	static int FeatureIndex(ChessTeam perspective, int king_square, int square, ChessPiece piece, ChessTeam team) {
+		int flip = (perspective == ChessTeam::WHITE) ? 0 : SQUARES - SIDE;
+		int kind = (int(piece) - int(ChessPiece::PAWN)) * 2 + ((team == perspective) ? 0 : 1);
+		return ((king_square ^ flip) * PIECE_KINDS + kind) * SQUARES + (square ^ flip);
+	}
+
+	// Is a tile counted as a feature: a pawn, rook, bishop, knight or queen of a playing team
+	static bool IsFeature(ChessPiece piece, ChessTeam team) {
+		return team != ChessTeam::NEUTRAL && piece != ChessPiece::EMPTY && piece != ChessPiece::KING;
+	}
+
+	// Returns 'false' and keeps the weights it had if the file can't be read or its sizes don't match
+	bool Load(const std::string& path) {
+		std::ifstream file(path, std::ios::binary);
+		char magic[4] = {};
+		uint32_t header[4] = {};
+		file.read(magic, sizeof(magic));
+		file.read(reinterpret_cast<char*>(header), sizeof(header));
+		if (!file || std::memcmp(magic, FILE_MAGIC, sizeof(magic)) != 0 || header[0] != FILE_VERSION ||
+			header[1] != HIDDEN || header[2] != L1 || header[3] != L2) {
+			return false;
+		}
+		NnueNetwork loaded;
+		loaded.feature_biases_.resize(HIDDEN);
+		loaded.feature_weights_.resize(size_t(FEATURES) * HIDDEN);
+		loaded.l1_biases_.resize(L1);
+		loaded.l1_weights_.resize(size_t(L1) * 2 * HIDDEN);
+		loaded.l2_biases_.resize(L2);
+		loaded.l2_weights_.resize(size_t(L2) * L1);
+		loaded.output_weights_.resize(L2);
+		ReadArray(file, loaded.feature_biases_);
+		ReadArray(file, loaded.feature_weights_);
+		ReadArray(file, loaded.l1_biases_);
+		ReadArray(file, loaded.l1_weights_);
+		ReadArray(file, loaded.l2_biases_);
+		ReadArray(file, loaded.l2_weights_);
+		file.read(reinterpret_cast<char*>(&loaded.output_bias_), sizeof(loaded.output_bias_));
+		ReadArray(file, loaded.output_weights_);
+		// Nothing may be left over either
+		if (!file || file.peek() != std::char_traits<char>::eof()) {
+			return false;
+		}
+		*this = std::move(loaded);
+		return true;
+	}
+
+	bool IsLoaded() const {
+		return !feature_weights_.empty();
+	}
+
+	const int16_t* GetFeatureBiases() const {
+		return feature_biases_.data();
+	}
+
+	// HIDDEN weights of one feature
+	const int16_t* GetFeatureColumn(int feature) const {
+		return feature_weights_.data() + size_t(feature) * HIDDEN;
+	}
+
+	// Value for the side to move in hundredths of a pawn, from its accumulator sums and those of the other side
+	int Propagate(const int16_t* own, const int16_t* other) const {
+		alignas(32) uint8_t input[2 * HIDDEN];
+		alignas(32) uint8_t hidden1[L1];
+		alignas(32) uint8_t hidden2[L2];
+		ClipSums(own, input, HIDDEN);
+		ClipSums(other, input + HIDDEN, HIDDEN);
+		Affine(input, 2 * HIDDEN, l1_weights_.data(), l1_biases_.data(), hidden1, L1);
+		Affine(hidden1, L1, l2_weights_.data(), l2_biases_.data(), hidden2, L2);
+		return (output_bias_ + Dot(hidden2, output_weights_.data(), L2)) / OUTPUT_SCALE;
+	}
+
+	// Kernels of the accumulator, count must be a multiple of 16
+	static void AddColumn(int16_t* sums, const int16_t* column, int count) {
+#if defined(NNUE_USE_AVX2)
+		for (int i = 0; i < count; i += 16) {
+			__m256i* target = reinterpret_cast<__m256i*>(sums + i);
+			__m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + i));
+			_mm256_storeu_si256(target, _mm256_add_epi16(_mm256_loadu_si256(target), value));
+		}
+#elif defined(NNUE_USE_SSSE3)
+		for (int i = 0; i < count; i += 8) {
+			__m128i* target = reinterpret_cast<__m128i*>(sums + i);
+			__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + i));
+			_mm_storeu_si128(target, _mm_add_epi16(_mm_loadu_si128(target), value));
+		}
+#else
+		for (int i = 0; i < count; ++i) {
+			sums[i] = int16_t(sums[i] + column[i]);
+		}
+#endif
+	}
+
+	static void SubtractColumn(int16_t* sums, const int16_t* column, int count) {
+#if defined(NNUE_USE_AVX2)
+		for (int i = 0; i < count; i += 16) {
+			__m256i* target = reinterpret_cast<__m256i*>(sums + i);
+			__m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + i));
+			_mm256_storeu_si256(target, _mm256_sub_epi16(_mm256_loadu_si256(target), value));
+		}
+#elif defined(NNUE_USE_SSSE3)
+		for (int i = 0; i < count; i += 8) {
+			__m128i* target = reinterpret_cast<__m128i*>(sums + i);
+			__m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + i));
+			_mm_storeu_si128(target, _mm_sub_epi16(_mm_loadu_si128(target), value));
+		}
+#else
+		for (int i = 0; i < count; ++i) {
+			sums[i] = int16_t(sums[i] - column[i]);
+		}
+#endif
+	}
+
+private:
+	std::vector<int16_t> feature_biases_;
+	std::vector<int16_t> feature_weights_;
+	std::vector<int32_t> l1_biases_;
+	std::vector<int8_t> l1_weights_;
+	std::vector<int32_t> l2_biases_;
+	std::vector<int8_t> l2_weights_;
+	int32_t output_bias_ = 0;
+	std::vector<int8_t> output_weights_;
+
+	template <typename T>
+	static void ReadArray(std::ifstream& file, std::vector<T>& values) {
+		file.read(reinterpret_cast<char*>(values.data()), std::streamsize(values.size() * sizeof(T)));
+	}
+
+	// int16 sums clipped to [0, ACTIVATION_MAX] bytes, count must be a multiple of 32
+	static void ClipSums(const int16_t* sums, uint8_t* output, int count) {
+#if defined(NNUE_USE_AVX2)
+		const __m256i limit = _mm256_set1_epi8(ACTIVATION_MAX);
+		for (int i = 0; i < count; i += 32) {
+			__m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sums + i));
+			__m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sums + i + 16));
+			// Packing works within 128-bit lanes, the permute puts the bytes back in order
+			__m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), _mm256_min_epu8(packed, limit));
+		}
+#elif defined(NNUE_USE_SSSE3)
+		const __m128i limit = _mm_set1_epi8(ACTIVATION_MAX);
+		for (int i = 0; i < count; i += 16) {
+			__m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + i));
+			__m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sums + i + 8));
+			__m128i packed = _mm_packus_epi16(low, high);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_min_epu8(packed, limit));
+		}
+#else
+		for (int i = 0; i < count; ++i) {
+			output[i] = uint8_t(std::clamp<int>(sums[i], 0, ACTIVATION_MAX));
+		}
+#endif
+	}
+
+	// Sum of input[i] * weights[i], count must be a multiple of 32
+	// A pair of products stays within int16 (2 * 127 * 128), as the byte kernels need
+	static int Dot(const uint8_t* input, const int8_t* weights, int count) {
+#if defined(NNUE_USE_AVX2)
+		const __m256i ones = _mm256_set1_epi16(1);
+		__m256i sum = _mm256_setzero_si256();
+		for (int i = 0; i < count; i += 32) {
+			__m256i products = _mm256_maddubs_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i)),
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i)));
+			sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+		}
+		__m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+		half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+		half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+		return _mm_cvtsi128_si32(half);
+#elif defined(NNUE_USE_SSSE3)
+		const __m128i ones = _mm_set1_epi16(1);
+		__m128i sum = _mm_setzero_si128();
+		for (int i = 0; i < count; i += 16) {
+			__m128i products = _mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i)),
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i)));
+			sum = _mm_add_epi32(sum, _mm_madd_epi16(products, ones));
+		}
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+		return _mm_cvtsi128_si32(sum);
+#else
+		int sum = 0;
+		for (int i = 0; i < count; ++i) {
+			sum += int(input[i]) * int(weights[i]);
+		}
+		return sum;
+#endif
+	}
+
+	// One int8 layer with clipped ReLU, weights are stored row by row, one row per output
+	static void Affine(const uint8_t* input, int input_count, const int8_t* weights, const int32_t* biases,
+		uint8_t* output, int output_count) {
+		for (int i = 0; i < output_count; ++i) {
+			int sum = biases[i] + Dot(input, weights + size_t(i) * input_count, input_count);
+			output[i] = uint8_t(std::clamp(sum >> WEIGHT_SHIFT, 0, ACTIVATION_MAX));
+		}
+	}
+};
+
+// First layer of an NnueNetwork kept in line with one board. Watching the board (see TileObserver), it adds and
+// subtracts the feature columns of pieces placed and removed, so making or unmaking a move costs a few column
+// additions instead of a pass over all pieces
+// A king move shifts every feature of its team, the sums of that team are then rebuilt from the board
+// the next time the position is evaluated
+// Watches the board from construction to destruction, the board and the network must outlive it
+class NnueAccumulator : public TileObserver {
+public:
+	// Expects a loaded network and NnueNetwork::Supports(board)
+	NnueAccumulator(const NnueNetwork& network, Chess& board) : network_(network), board_(board) {
+		board_.SetTileObserver(this);
+	}
+
+	NnueAccumulator(const NnueAccumulator&) = delete;
+
+	NnueAccumulator& operator=(const NnueAccumulator&) = delete;
+
+	~NnueAccumulator() override {
+		board_.SetTileObserver(nullptr);
+	}
+
+	// Value of the board for a team in hundredths of a pawn
+	// A team without exactly one king has no features, EvaluatePosition() values such positions as it does
+	// in a search without a network
+	int Evaluate(ChessTeam team) {
+		for (int side = 0; side < 2; ++side) {
+			if (is_dirty_[side] && !Refresh(side)) {
+				return EvaluatePosition(board_, team);
+			}
+		}
+		ChessTeam to_move = board_.WhoseMove();
+		int own = SideOf(to_move);
+		int value = network_.Propagate(sums_[own].values, sums_[1 - own].values);
+		return (team == to_move) ? value : -value;
+	}
+
+	void OnTileChanged(int square, PackedTile previous, PackedTile tile) override {
+		for (int side = 0; side < 2; ++side) {
+			if (is_dirty_[side]) {
+				continue;
+			}
+			ChessTeam perspective = TeamOf(side);
+			bool is_king_moved = (previous.Piece() == ChessPiece::KING && previous.Team() == perspective) ||
+				(tile.Piece() == ChessPiece::KING && tile.Team() == perspective);
+			if (is_king_moved) {
+				is_dirty_[side] = true;
+				continue;
+			}
+			if (NnueNetwork::IsFeature(previous.Piece(), previous.Team())) {
+				NnueNetwork::SubtractColumn(sums_[side].values, network_.GetFeatureColumn(NnueNetwork::FeatureIndex(
+					perspective, king_squares_[side], square, previous.Piece(), previous.Team())), NnueNetwork::HIDDEN);
+			}
+			if (NnueNetwork::IsFeature(tile.Piece(), tile.Team())) {
+				NnueNetwork::AddColumn(sums_[side].values, network_.GetFeatureColumn(NnueNetwork::FeatureIndex(
+					perspective, king_squares_[side], square, tile.Piece(), tile.Team())), NnueNetwork::HIDDEN);
+			}
+		}
+	}
+
+	void OnBoardRebuilt() override {
+		is_dirty_[0] = true;
+		is_dirty_[1] = true;
+	}
+
+private:
+	struct alignas(32) Sums {
+		int16_t values[NnueNetwork::HIDDEN];
+	};
+
+	const NnueNetwork& network_;
+	Chess& board_;
+	// Indexed by side: 0 white, 1 black
+	Sums sums_[2] = {};
+	int king_squares_[2] = {};
+	bool is_dirty_[2] = { true, true };
+
+	static int SideOf(ChessTeam team) {
+		return (team == ChessTeam::WHITE) ? 0 : 1;
+	}
+
+	static ChessTeam TeamOf(int side) {
+		return (side == 0) ? ChessTeam::WHITE : ChessTeam::BLACK;
+	}
+
+	// Sums of one side from scratch, returns 'false' if its team has no king or more than one
+	bool Refresh(int side) {
+		ChessTeam perspective = TeamOf(side);
+		int king_count = 0;
+		for (auto [row, column] : board_.GetPieces(perspective)) {
+			if (board_.LookUp(row, column).piece_type == ChessPiece::KING) {
+				king_squares_[side] = row * NnueNetwork::SIDE + column;
+				++king_count;
+			}
+		}
+		if (king_count != 1) {
+			return false;
+		}
+		int16_t* sums = sums_[side].values;
+		std::copy(network_.GetFeatureBiases(), network_.GetFeatureBiases() + NnueNetwork::HIDDEN, sums);
+		for (ChessTeam team : { ChessTeam::WHITE, ChessTeam::BLACK }) {
+			for (auto [row, column] : board_.GetPieces(team)) {
+				BoardTile tile = board_.LookUp(row, column);
+				if (NnueNetwork::IsFeature(tile.piece_type, tile.piece_team)) {
+					NnueNetwork::AddColumn(sums, network_.GetFeatureColumn(NnueNetwork::FeatureIndex(perspective,
+						king_squares_[side], row * NnueNetwork::SIDE + column, tile.piece_type, tile.piece_team)),
+						NnueNetwork::HIDDEN);
+				}
+			}
+		}
+		is_dirty_[side] = false;
+		return true;
+	}
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "chess.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Pawn structure of a position, only depends on where the pawns of both teams stand
+// Scores are in hundredths of a pawn and counted for white, black's are their negation
+struct PawnEntry {
+	uint64_t key = 0;                    // Chess::GetPawnKey() of the pawns described
+	int16_t middlegame = 0;
+	int16_t endgame = 0;
+	Bitboard passed[2] = {};             // Passed pawns of white and black, left empty on boards other than 8x8
+};
+
+// Small cache of pawn structures keyed by Chess::GetPawnKey(). The pawns of a search change far less often
+// than the rest of the board, so nearly every lookup hits
+// Not shared between threads, each search thread keeps its own. A slot takes every new entry
+class PawnTable {
+public:
+	static constexpr size_t DEFAULT_ENTRIES = 1 << 13;
+
+	// Rounded down to a power of two, at least one
+	PawnTable(size_t entries = DEFAULT_ENTRIES) {
+		size_t count = 1;
+		while (count * 2 <= entries) {
+			count *= 2;
+		}
+		entries_ = std::make_unique<PawnEntry[]>(count);
+		mask_ = count - 1;
+	}
+
+	// nullptr if the pawns are not stored. A fresh table answers a board without pawns (key 0) with an empty
+	// entry, which is the right one
+	const PawnEntry* Probe(uint64_t key) const {
+		const PawnEntry& entry = entries_[key & mask_];
+		return (entry.key == key) ? &entry : nullptr;
+	}
+
+	const PawnEntry& Store(const PawnEntry& entry) {
+		PawnEntry& slot = entries_[entry.key & mask_];
+		slot = entry;
+		return slot;
+	}
+
+private:
+	std::unique_ptr<PawnEntry[]> entries_;
+	size_t mask_ = 0;
+};
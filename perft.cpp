@@ -0,0 +1,292 @@
+// Perft: counts leaf nodes of the legal move tree to validate move generation and measure its speed
+// Separate executable, build it from this file and every .cpp of the library except main.cpp
+//
+// perft                                  runs the built-in suite and checks known node counts
+// perft --fen "<fen>" --depth N          counts one position
+// options: --divide (nodes per root move), --threads N (root moves are split between threads)
+//
+// FEN ranks may be of any equal width (multi-digit empty runs allowed), so boards other than 8x8 work too.
+// Rank 1 is the last row of the board, white pawns move towards row 0
+
+#include "chess.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+	struct PerftCase {
+		const char* name;
+		const char* fen;
+		vector<uint64_t> expected;                      // Node counts for depth 1, 2, ...
+	};
+
+	// Standard positions from the chess programming community, covering castling, en passant and promotions
+	const vector<PerftCase> PERFT_SUITE = {
+		{ "start", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", { 20, 400, 8902, 197281, 4865609 } },
+		{ "kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", { 48, 2039, 97862, 4085603 } },
+		{ "position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", { 14, 191, 2812, 43238, 674624 } },
+		{ "position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", { 6, 264, 9467, 422333, 15833292 } },
+		{ "position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", { 44, 1486, 62379, 2103487 } },
+		{ "position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", { 46, 2079, 89890, 3894594 } },
+	};
+
+	ChessPiece PieceFromLetter(char letter) {
+		switch (tolower(letter)) {
+		case 'p':
+			return ChessPiece::PAWN;
+		case 'n':
+			return ChessPiece::KNIGHT;
+		case 'b':
+			return ChessPiece::BISHOP;
+		case 'r':
+			return ChessPiece::ROOK;
+		case 'q':
+			return ChessPiece::QUEEN;
+		case 'k':
+			return ChessPiece::KING;
+		default:
+			return ChessPiece::EMPTY;
+		}
+	}
+
+	// Castling rights become has_moved flags: a right keeps the king and the first rook on that side unmoved
+	// Pawns count as moved unless they stand on their starting row
+	bool LoadFen(const string& fen, Chess& board) {
+		istringstream fields(fen);
+		string placement, side, castling, en_passant;
+		fields >> placement >> side >> castling >> en_passant;
+
+		vector<vector<BoardTile>> rows(1);
+		for (size_t i = 0; i < placement.size(); ++i) {
+			char symbol = placement[i];
+			if (symbol == '/') {
+				rows.emplace_back();
+			}
+			else if (isdigit(symbol)) {
+				int empty_count = 0;
+				for (; i < placement.size() && isdigit(placement[i]); ++i) {
+					empty_count = empty_count * 10 + (placement[i] - '0');
+				}
+				--i;
+				rows.back().insert(rows.back().end(), empty_count, BoardTile());
+			}
+			else if (PieceFromLetter(symbol) != ChessPiece::EMPTY) {
+				ChessTeam team = isupper(symbol) ? ChessTeam::WHITE : ChessTeam::BLACK;
+				rows.back().push_back({ PieceFromLetter(symbol), team, true });
+			}
+			else {
+				return false;
+			}
+		}
+		int row_count = int(rows.size());
+		int column_count = int(rows.front().size());
+		for (const vector<BoardTile>& row : rows) {
+			if (int(row.size()) != column_count) {
+				return false;
+			}
+		}
+		if (row_count * column_count == 0 || row_count * column_count > Chess::MAX_TILES) {
+			return false;
+		}
+
+		for (int row = 0; row < row_count; ++row) {
+			for (int column = 0; column < column_count; ++column) {
+				BoardTile& tile = rows[row][column];
+				if (tile.piece_type == ChessPiece::PAWN) {
+					tile.has_moved = !((tile.piece_team == ChessTeam::WHITE && row == row_count - 2) ||
+						(tile.piece_team == ChessTeam::BLACK && row == 1));
+				}
+			}
+		}
+		for (char right : castling) {
+			if (right == '-') {
+				continue;
+			}
+			ChessTeam team = isupper(right) ? ChessTeam::WHITE : ChessTeam::BLACK;
+			int increment = (tolower(right) == 'k') ? 1 : -1;
+			for (int row = 0; row < row_count; ++row) {
+				for (int column = 0; column < column_count; ++column) {
+					BoardTile& king = rows[row][column];
+					if (king.piece_type != ChessPiece::KING || king.piece_team != team) {
+						continue;
+					}
+					for (int pos = column + increment; pos >= 0 && pos < column_count; pos += increment) {
+						BoardTile& rook = rows[row][pos];
+						if (rook.piece_type == ChessPiece::ROOK && rook.piece_team == team) {
+							rook.has_moved = false;
+							king.has_moved = false;
+							break;
+						}
+					}
+				}
+			}
+		}
+
+		board = Chess(row_count, column_count);
+		for (int row = 0; row < row_count; ++row) {
+			for (int column = 0; column < column_count; ++column) {
+				if (rows[row][column].piece_type != ChessPiece::EMPTY) {
+					board.PutPieceInPosition(rows[row][column], row, column);
+				}
+			}
+		}
+		if (side == "b") {
+			board.SwitchTurnSequence();
+		}
+		if (en_passant.size() >= 2 && en_passant != "-") {
+			int column = en_passant[0] - 'a';
+			int rank = atoi(en_passant.c_str() + 1);
+			board.SetEnpassantData({ true, { row_count - rank, column } });
+		}
+		return true;
+	}
+
+	uint64_t Perft(Chess& board, int depth, vector<MoveBuffer>& buffers) {
+		MoveBuffer& moves = buffers[depth];
+		board.GenerateLegalMoves(moves);
+		if (depth == 1) {
+			return moves.size();
+		}
+		uint64_t nodes = 0;
+		for (Move move : moves) {
+			Chess::UndoInfo undo = board.MakeMove(move);
+			nodes += Perft(board, depth - 1, buffers);
+			board.UnmakeMove(move, undo);
+		}
+		return nodes;
+	}
+
+	string MoveName(Move move, int rows, int columns) {
+		auto square_name = [&](int square) {
+			return string(1, char('a' + square % columns)) + to_string(rows - square / columns);
+		};
+		string name = square_name(move.From()) + square_name(move.To());
+		switch (move.Promotion()) {
+		case ChessPiece::QUEEN:
+			return name + 'q';
+		case ChessPiece::ROOK:
+			return name + 'r';
+		case ChessPiece::BISHOP:
+			return name + 'b';
+		case ChessPiece::KNIGHT:
+			return name + 'n';
+		default:
+			return name;
+		}
+	}
+
+	// Root moves are handed out to threads one by one, every thread works on its own copy of the board
+	uint64_t RunPerft(const Chess& board, int depth, int thread_count, bool divide) {
+		MoveBuffer root_moves;
+		board.GenerateLegalMoves(root_moves);
+		if (depth <= 1 && !divide) {
+			return depth == 1 ? root_moves.size() : 1;
+		}
+		vector<uint64_t> move_nodes(root_moves.size(), 0);
+		atomic<size_t> next_move = 0;
+		auto worker = [&]() {
+			Chess local(board);
+			vector<MoveBuffer> buffers(depth + 1);
+			for (size_t i = next_move++; i < root_moves.size(); i = next_move++) {
+				Chess::UndoInfo undo = local.MakeMove(root_moves[i]);
+				move_nodes[i] = (depth > 1) ? Perft(local, depth - 1, buffers) : 1;
+				local.UnmakeMove(root_moves[i], undo);
+			}
+		};
+		vector<thread> threads;
+		for (int i = 1; i < thread_count; ++i) {
+			threads.emplace_back(worker);
+		}
+		worker();
+		for (thread& t : threads) {
+			t.join();
+		}
+
+		uint64_t nodes = 0;
+		pair<int, int> dims = board.GetDimensions();
+		for (size_t i = 0; i < root_moves.size(); ++i) {
+			if (divide) {
+				cout << MoveName(root_moves[i], dims.first, dims.second) << ": " << move_nodes[i] << '\n';
+			}
+			nodes += move_nodes[i];
+		}
+		return nodes;
+	}
+
+	// Prints one result line and returns the node count
+	uint64_t TimedPerft(const Chess& board, int depth, int thread_count, bool divide) {
+		auto start = chrono::steady_clock::now();
+		uint64_t nodes = RunPerft(board, depth, thread_count, divide);
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		cout << "depth " << depth << "  nodes " << nodes << "  time " << int(seconds * 1000) << " ms";
+		if (seconds > 0) {
+			cout << "  " << uint64_t(nodes / seconds) << " nodes/s";
+		}
+		cout << endl;
+		return nodes;
+	}
+}
+
+int main(int argc, char** argv) {
+	string fen;
+	int depth = 0;
+	int thread_count = 1;
+	bool divide = false;
+	for (int i = 1; i < argc; ++i) {
+		string argument = argv[i];
+		if (argument == "--fen" && i + 1 < argc) {
+			fen = argv[++i];
+		}
+		else if (argument == "--depth" && i + 1 < argc) {
+			depth = atoi(argv[++i]);
+		}
+		else if (argument == "--threads" && i + 1 < argc) {
+			thread_count = max(1, atoi(argv[++i]));
+		}
+		else if (argument == "--divide") {
+			divide = true;
+		}
+		else {
+			cerr << "usage: perft [--fen \"<fen>\"] [--depth N] [--divide] [--threads N]" << endl;
+			return 2;
+		}
+	}
+
+	if (!fen.empty()) {
+		Chess board;
+		if (!LoadFen(fen, board)) {
+			cerr << "Can't read FEN: " << fen << endl;
+			return 2;
+		}
+		TimedPerft(board, max(depth, 1), thread_count, divide);
+		return 0;
+	}
+
+	// Suite: every position up to its deepest known count, or up to --depth
+	bool all_match = true;
+	for (const PerftCase& test : PERFT_SUITE) {
+		Chess board;
+		LoadFen(test.fen, board);
+		cout << test.name << endl;
+		int last_depth = (depth > 0) ? min<int>(depth, int(test.expected.size())) : int(test.expected.size());
+		for (int d = 1; d <= last_depth; ++d) {
+			uint64_t nodes = TimedPerft(board, d, thread_count, divide && d == last_depth);
+			if (nodes != test.expected[d - 1]) {
+				cout << "  MISMATCH, expected " << test.expected[d - 1] << endl;
+				all_match = false;
+			}
+		}
+	}
+	cout << (all_match ? "All node counts match" : "Node counts differ") << endl;
+	return all_match ? 0 : 1;
+}
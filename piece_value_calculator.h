@@ -1,90 +1,129 @@
 #pragma once
 
 #include "chess.h"
+#include "pawn_table.h"
 
+#include <algorithm>
 #include <tuple>
+#include <vector>
+
+// Search values count in hundredths of a pawn
+constexpr int PAWN_SCORE = 100;
 
 uint8_t GivePieceValue(ChessPiece piece) {
-	switch (piece) {
-	default:
-		return 0i8;
-	case ChessPiece::PAWN:
-		return 1i8;
-	case ChessPiece::KNIGHT:
-		return 3i8;
-	case ChessPiece::BISHOP:
-		return 3i8;
-	case ChessPiece::ROOK:
-		return 5i8;
-	case ChessPiece::QUEEN:
-		return 9i8;
-	}	
+	return uint8_t(Chess::PieceValue(piece));
 }
 
+// Read from the material the board keeps up to date, no scan
 uint32_t GiveBoardValue(const Chess& board, ChessTeam team) {
-	uint32_t counter = 0;
-	std::pair<int, int> dims = board.GetDimensions();
-	for (int n = 0; n < dims.first; ++n) {
-		for (int m = 0; m < dims.second; ++m) {
-			BoardTile tile = board.LookUp(n, m);
-			if (tile.piece_team == team) {
-				counter += GivePieceValue(tile.piece_type);
-			}
-		}
-	}
-	return counter;
+	return uint32_t(board.GetMaterial(team));
 }
 
-/*class ValueCalculator {
-public:
+// Static value of a position for a team in hundredths of a pawn: material and piece-square scores, each minus
+// those of the other team. Piece-square scores blend from the middlegame tables to the endgame ones
+// as pieces leave the board (Chess::GetPhase())
+// Costs the same at any node of a search, however many pieces are left
+int EvaluateBoard(const Chess& board, ChessTeam team) {
+	ChessTeam enemy = (team == ChessTeam::WHITE) ? ChessTeam::BLACK : ChessTeam::WHITE;
+	int material = (board.GetMaterial(team) - board.GetMaterial(enemy)) * PAWN_SCORE;
+	int middlegame = board.GetSquareScore(team, 0) - board.GetSquareScore(enemy, 0);
+	int endgame = board.GetSquareScore(team, 1) - board.GetSquareScore(enemy, 1);
+	int phase = std::min(board.GetPhase(), Chess::FULL_PHASE);
+	return material + (middlegame * phase + endgame * (Chess::FULL_PHASE - phase)) / Chess::FULL_PHASE;
+}
 
-	ValueCalculator() = default;
+// Pawn structure terms in hundredths of a pawn, middlegame and endgame. Doubled pawns count every pawn after
+// the first one on a column, isolated pawns have no own pawns on the columns next to theirs, passed pawns
+// are the front pawn of their column and have no enemy pawns ahead of them on their own or the next columns
+constexpr int DOUBLED_PAWN[2] = { -10, -20 };
+constexpr int ISOLATED_PAWN[2] = { -10, -15 };
+// By rows left to the promotion row, the last value counts for all farther ones
+constexpr int PASSED_PAWN[2][7] = { { 0, 60, 40, 25, 15, 10, 5 }, { 0, 120, 80, 50, 30, 15, 10 } };
+// Passed pawn with a piece right in front of it, added at every node from the passed pawns of the entry
+constexpr int BLOCKED_PASSED_PAWN[2] = { -5, -25 };
 
-	ValueCalculator(const Chess& board) {
-		std::pair<int, int> dims = board.GetDimensions();
-		for (int n = 0; n < dims.first; ++n) {
-			for (int m = 0; m < dims.second; ++m) {
-				BoardTile tile = board.LookUp(n, m);
-				if (tile.piece_team == ChessTeam::WHITE) {
-					white_ += GivePieceValue(tile.piece_type);
-				}
-				if (tile.piece_team == ChessTeam::BLACK) {
-					black_ += GivePieceValue(tile.piece_type);
-				}
+// Pawn structure of the board from scratch, see PawnEntry
+PawnEntry ComputePawnEntry(const Chess& board) {
+	PawnEntry entry;
+	entry.key = board.GetPawnKey();
+	auto [rows, columns] = board.GetDimensions();
+	bool has_bitboards = (rows == BITBOARD_SIDE && columns == BITBOARD_SIDE);
+	// Indexed by side (0 white, 1 black) and column: pawn count, row of the pawn nearest to row 0 and
+	// of the one nearest to the last row
+	std::vector<int> counts[2];
+	std::vector<int> first_rows[2];
+	std::vector<int> last_rows[2];
+	std::vector<std::pair<int, int>> pawns[2];
+	for (int side = 0; side < 2; ++side) {
+		counts[side].assign(columns, 0);
+		first_rows[side].assign(columns, rows);
+		last_rows[side].assign(columns, -1);
+		for (auto [row, column] : board.GetPieces(side == 0 ? ChessTeam::WHITE : ChessTeam::BLACK)) {
+			if (board.LookUp(row, column).piece_type != ChessPiece::PAWN) {
+				continue;
 			}
+			pawns[side].push_back({ row, column });
+			++counts[side][column];
+			first_rows[side][column] = std::min(first_rows[side][column], row);
+			last_rows[side][column] = std::max(last_rows[side][column], row);
 		}
 	}
-
-	uint32_t GetTotalValue(const ChessTeam team) const {
-		if (team == ChessTeam::WHITE) {
-			return white_;
+	int scores[2][2] = {};
+	for (int side = 0; side < 2; ++side) {
+		for (int column = 0; column < columns; ++column) {
+			for (int phase = 0; phase < 2; ++phase) {
+				scores[side][phase] += std::max(counts[side][column] - 1, 0) * DOUBLED_PAWN[phase];
+			}
 		}
-		else {
-			return black_;
+		// White pawns move towards row 0, black ones towards the last row
+		for (auto [row, column] : pawns[side]) {
+			bool is_isolated = true;
+			bool is_passed = (side == 0) ? first_rows[0][column] == row : last_rows[1][column] == row;
+			for (int next = std::max(column - 1, 0); next <= std::min(column + 1, columns - 1); ++next) {
+				if (next != column && counts[side][next] > 0) {
+					is_isolated = false;
+				}
+				if (side == 0 ? first_rows[1][next] < row : last_rows[0][next] > row) {
+					is_passed = false;
+				}
+			}
+			int rows_left = std::min((side == 0) ? row : rows - 1 - row, 6);
+			for (int phase = 0; phase < 2; ++phase) {
+				scores[side][phase] += (is_isolated ? ISOLATED_PAWN[phase] : 0) +
+					(is_passed ? PASSED_PAWN[phase][rows_left] : 0);
+			}
+			if (is_passed && has_bitboards) {
+				entry.passed[side] |= SquareBit(row * columns + column);
+			}
 		}
 	}
+	entry.middlegame = int16_t(scores[0][0] - scores[1][0]);
+	entry.endgame = int16_t(scores[0][1] - scores[1][1]);
+	return entry;
+}
 
-	// Do not give empty tiles to this method
-	void Remove(const BoardTile& tile) {
-		if (tile.piece_team == ChessTeam::WHITE) {
-			white_ -= GivePieceValue(tile.piece_type);
-		}
-		else {
-			black_ -= GivePieceValue(tile.piece_type);
-		}
+// Static value of a position for a team in hundredths of a pawn: EvaluateBoard() and the pawn structure
+// The structure is looked up in a pawn table of the calling thread and only computed for new pawns
+int EvaluatePosition(const Chess& board, ChessTeam team) {
+	thread_local PawnTable pawn_table;
+	const PawnEntry* pawns = pawn_table.Probe(board.GetPawnKey());
+	if (pawns == nullptr) {
+		pawns = &pawn_table.Store(ComputePawnEntry(board));
 	}
-	void Add(const BoardTile& tile) {
-		if (tile.piece_team == ChessTeam::WHITE) {
-			white_ += GivePieceValue(tile.piece_type);
-		}
-		else if (tile.piece_team == ChessTeam::BLACK) {
-			black_ += GivePieceValue(tile.piece_type);
+	int middlegame = pawns->middlegame;
+	int endgame = pawns->endgame;
+	for (int side = 0; side < 2; ++side) {
+		int sign = (side == 0) ? 1 : -1;
+		for (Bitboard passed = pawns->passed[side]; passed != 0;) {
+			int square = PopLowestSquare(passed);
+			int front_row = square / BITBOARD_SIDE + ((side == 0) ? -1 : 1);
+			if (board.LookUp(front_row, square % BITBOARD_SIDE).piece_type != ChessPiece::EMPTY) {
+				middlegame += sign * BLOCKED_PASSED_PAWN[0];
+				endgame += sign * BLOCKED_PASSED_PAWN[1];
+			}
 		}
 	}
-
-private:
-	uint32_t white_ = 0;
-	uint32_t black_ = 0;
-
-};
-*/
\ No newline at end of file
+	int phase = std::min(board.GetPhase(), Chess::FULL_PHASE);
+	int structure = (middlegame * phase + endgame * (Chess::FULL_PHASE - phase)) / Chess::FULL_PHASE;
+	return EvaluateBoard(board, team) + ((team == ChessTeam::WHITE) ? structure : -structure);
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "chess.h"
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// What a stored score tells about the exact value of a position
+enum class TableBound : uint8_t {
+	NONE,
+
+	UPPER,                               // Exact value is at most the score (no move reached alpha)
+	LOWER,                               // Exact value is at least the score (a move reached beta)
+	EXACT
+};
+
+// One position as read back from the table. Scores are counted from the side to move
+struct TableEntry {
+	Move move;                           // Best move found, an empty Move if there was none
+	int score = 0;
+	int depth = 0;                       // Plies searched below the position, quiescence not counted
+	TableBound bound = TableBound::NONE;
+};
+
+// Fixed-size transposition table keyed by Chess::GetZobristKey(), shared by all threads of a search
+// Buckets hold two slots: the first keeps the deepest entry of the current search, the second takes every
+// entry the first one refuses. A slot is two 64-bit words, the key XOR-ed with the data and the data itself.
+// Words are written and read without locks, a slot torn by two threads writing at once fails the key check
+// and reads as a miss
+class TranspositionTable {
+public:
+	static constexpr size_t DEFAULT_MB = 16;
+
+	// Scores are stored in 20 bits. A score beyond the limit is kept as a bound at the limit,
+	// which only positions without moves (see Refresh_Values) can reach
+	static constexpr int SCORE_LIMIT = (1 << 19) - 1;
+
+	TranspositionTable(size_t megabytes = DEFAULT_MB) {
+		Resize(megabytes);
+	}
+
+	// Rounded down to a power of two of buckets, at least one. Entries are dropped
+	void Resize(size_t megabytes) {
+		size_t bucket_count = 1;
+		while (bucket_count * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024) {
+			bucket_count *= 2;
+		}
+		buckets_ = std::make_unique<Bucket[]>(bucket_count);
+		bucket_mask_ = bucket_count - 1;
+		generation_ = 0;
+	}
+
+	// Drops all entries, call it when a new game starts
+	void Clear() {
+		for (size_t i = 0; i <= bucket_mask_; ++i) {
+			for (Slot& slot : buckets_[i].slots) {
+				slot.check.store(0, std::memory_order_relaxed);
+				slot.data.store(0, std::memory_order_relaxed);
+			}
+		}
+		generation_ = 0;
+	}
+
+	// Called once before each search. Entries of older searches lose their claim on the depth-preferred slot
+	void NewSearch() {
+		generation_ = (generation_ + 1) & GENERATION_MASK;
+	}
+
+	size_t GetSizeBytes() const {
+		return (bucket_mask_ + 1) * sizeof(Bucket);
+	}
+
+	// Returns 'false' if the position is not stored
+	bool Probe(uint64_t key, TableEntry& entry) const {
+		for (const Slot& slot : buckets_[key & bucket_mask_].slots) {
+			uint64_t data = slot.data.load(std::memory_order_relaxed);
+			uint64_t check = slot.check.load(std::memory_order_relaxed);
+			if ((check ^ data) == key && Bound(data) != TableBound::NONE) {
+				entry = Unpack(data);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void Store(uint64_t key, int depth, TableBound bound, int score, Move move) {
+		// A bound stays true when moved outwards, an exact score beyond the limit becomes a bound
+		if (score > SCORE_LIMIT) {
+			if (bound == TableBound::UPPER) {
+				return;
+			}
+			score = SCORE_LIMIT;
+			bound = TableBound::LOWER;
+		}
+		else if (score < -SCORE_LIMIT) {
+			if (bound == TableBound::LOWER) {
+				return;
+			}
+			score = -SCORE_LIMIT;
+			bound = TableBound::UPPER;
+		}
+		Bucket& bucket = buckets_[key & bucket_mask_];
+		Slot& deep = bucket.slots[0];
+		uint64_t deep_data = deep.data.load(std::memory_order_relaxed);
+		bool is_deep_key = (deep.check.load(std::memory_order_relaxed) ^ deep_data) == key;
+		bool takes_deep = is_deep_key || Bound(deep_data) == TableBound::NONE ||
+			Generation(deep_data) != generation_ || depth >= Depth(deep_data);
+		Slot& slot = takes_deep ? deep : bucket.slots[1];
+		// A search that found no move keeps the move stored before it
+		if (move == Move()) {
+			uint64_t old_data = slot.data.load(std::memory_order_relaxed);
+			if ((slot.check.load(std::memory_order_relaxed) ^ old_data) == key) {
+				move = Unpack(old_data).move;
+			}
+		}
+		uint64_t data = Pack(depth, bound, score, move);
+		slot.check.store(key ^ data, std::memory_order_relaxed);
+		slot.data.store(data, std::memory_order_relaxed);
+	}
+
+private:
+	// Data word: bits 0-31 move, 32-51 score + SCORE_LIMIT, 52-59 depth, 60-61 bound, 62-63 generation
+	static constexpr int SCORE_SHIFT = 32;
+	static constexpr int DEPTH_SHIFT = 52;
+	static constexpr int BOUND_SHIFT = 60;
+	static constexpr int GENERATION_SHIFT = 62;
+	static constexpr uint64_t SCORE_MASK = (uint64_t(1) << 20) - 1;
+	static constexpr uint64_t DEPTH_MASK = 0xFF;
+	static constexpr uint64_t BOUND_MASK = 0b11;
+	static constexpr uint8_t GENERATION_MASK = 0b11;
+
+	struct Slot {
+		std::atomic<uint64_t> check{ 0 };
+		std::atomic<uint64_t> data{ 0 };
+	};
+
+	// Two buckets share a 64 byte cache line
+	struct alignas(32) Bucket {
+		Slot slots[2];
+	};
+
+	std::unique_ptr<Bucket[]> buckets_;
+	size_t bucket_mask_ = 0;
+	uint8_t generation_ = 0;
+
+	uint64_t Pack(int depth, TableBound bound, int score, Move move) const {
+		static_assert(sizeof(uint32_t) == sizeof(Move), "Move must fit the low word");
+		uint32_t move_bits = std::bit_cast<uint32_t>(move);
+		return uint64_t(move_bits) | (uint64_t(score + SCORE_LIMIT) << SCORE_SHIFT) |
+			(uint64_t(std::min(depth, int(DEPTH_MASK))) << DEPTH_SHIFT) | (uint64_t(bound) << BOUND_SHIFT) |
+			(uint64_t(generation_) << GENERATION_SHIFT);
+	}
+
+	static TableEntry Unpack(uint64_t data) {
+		TableEntry entry;
+		entry.move = std::bit_cast<Move>(uint32_t(data));
+		entry.score = int((data >> SCORE_SHIFT) & SCORE_MASK) - SCORE_LIMIT;
+		entry.depth = Depth(data);
+		entry.bound = Bound(data);
+		return entry;
+	}
+
+	static int Depth(uint64_t data) {
+		return int((data >> DEPTH_SHIFT) & DEPTH_MASK);
+	}
+
+	static TableBound Bound(uint64_t data) {
+		return TableBound((data >> BOUND_SHIFT) & BOUND_MASK);
+	}
+
+	static uint8_t Generation(uint64_t data) {
+		return uint8_t(data >> GENERATION_SHIFT);
+	}
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads that run batches of tasks, kept alive between batches
+// Every worker has its own task queue. It takes tasks from the back of it and, once it runs dry, steals from
+// the front of the other queues, so workers that got short tasks help out those that got long ones
+// A task is told the index of the worker running it, meant for per-worker scratch state
+class WorkStealingPool {
+public:
+	using Task = std::function<void(int worker)>;
+
+	// At least one worker
+	explicit WorkStealingPool(int threads) {
+		int count = std::max(threads, 1);
+		for (int i = 0; i < count; ++i) {
+			queues_.push_back(std::make_unique<Queue>());
+		}
+		for (int i = 0; i < count; ++i) {
+			workers_.emplace_back(&WorkStealingPool::Work, this, i);
+		}
+	}
+
+	WorkStealingPool(const WorkStealingPool&) = delete;
+
+	WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+	~WorkStealingPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			is_closing_ = true;
+		}
+		wake_.notify_all();
+		for (std::thread& worker : workers_) {
+			worker.join();
+		}
+	}
+
+	int GetThreadCount() const {
+		return int(workers_.size());
+	}
+
+	// Hands the tasks out round-robin and returns once all of them are done. One batch at a time
+	void Run(std::vector<Task> tasks) {
+		if (tasks.empty()) {
+			return;
+		}
+		// Counted before the first task is queued, a worker still busy with the last batch may take it right away
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			pending_ = tasks.size();
+		}
+		for (size_t i = 0; i < tasks.size(); ++i) {
+			Queue& queue = *queues_[i % queues_.size()];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.tasks.push_back(std::move(tasks[i]));
+		}
+		// Sleeping workers wake up only once all tasks are queued
+		std::unique_lock<std::mutex> lock(mutex_);
+		++batch_;
+		wake_.notify_all();
+		done_.wait(lock, [this] { return pending_ == 0; });
+	}
+
+private:
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	std::vector<std::unique_ptr<Queue>> queues_;
+	std::vector<std::thread> workers_;
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	std::condition_variable done_;
+	size_t pending_ = 0;                 // Tasks of the running batch not finished yet
+	size_t batch_ = 0;
+	bool is_closing_ = false;
+
+	// Own queue from the back first, then the others from the front
+	bool TakeTask(int worker, Task& task) {
+		for (size_t i = 0; i < queues_.size(); ++i) {
+			bool is_own = (i == 0);
+			Queue& queue = *queues_[(worker + i) % queues_.size()];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.tasks.empty()) {
+				task = std::move(is_own ? queue.tasks.back() : queue.tasks.front());
+				is_own ? queue.tasks.pop_back() : queue.tasks.pop_front();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void Work(int worker) {
+		size_t seen_batch = 0;
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				wake_.wait(lock, [&] { return is_closing_ || batch_ != seen_batch; });
+				if (is_closing_) {
+					return;
+				}
+				seen_batch = batch_;
+			}
+			Task task;
+			while (TakeTask(worker, task)) {
+				task(worker);
+				std::lock_guard<std::mutex> lock(mutex_);
+				if (--pending_ == 0) {
+					done_.notify_all();
+				}
+			}
+		}
+	}
+};